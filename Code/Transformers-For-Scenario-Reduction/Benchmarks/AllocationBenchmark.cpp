@@ -0,0 +1,126 @@
+#include "Benchmark.h"
+
+#include <filesystem>
+#include <streambuf>
+
+#include "AllocationCounter.h"
+
+
+// Generates scenarios after a warm-up scenario has sized the working storage, and checks that
+// none of them allocates
+template <typename Generator>
+static bool checkNoAllocations(BenchmarkScenarios& scenarios, Generator& rng, const string& name)
+{
+    constexpr int NumScenarios = 20;
+
+    long long start = allocationCount();
+
+    scenarios.generate(1, rng);
+
+    long long before = allocationCount();
+
+    for (auto i = 2; i <= NumScenarios + 1; i++)
+        scenarios.generate(i, rng);
+
+    long long allocations = allocationCount() - before;
+
+    std::cout << "  " << name << ": " << before - start << " allocations in the first scenario, "
+              << allocations << " in the " << NumScenarios << " after it\n";
+
+    return check(allocations == 0, name + " generates a 100 year monthly scenario without allocating");
+}
+
+
+// Swallows the run's progress lines without allocating
+struct NullBuffer : std::streambuf
+{
+    int overflow(int c) override
+    {
+        return c;
+    }
+};
+
+
+// Allocations made by generateAllScenarios() for a whole one-thread run of numScenarios 100 year monthly
+// scenarios in binary format, or valued in-process with the GMIB model instead of written
+static long long runAllocations(const BenchmarkOptions& options, const BenchmarkScenarios& scenarios, const string& outputDir, int numScenarios, bool batch, bool value)
+{
+    NullBuffer discard;
+    std::streambuf* console = std::cout.rdbuf(&discard);
+
+    try
+    {
+        ScenarioGenerator generator;
+
+        generator.loadHistoricalCurves(options.historyDir, options.historyFile);
+
+        if (value)
+            generator.valueScenarios(ValuationParams{ .num_months = BenchmarkScenarios::ProjectionYears * 12, .maturity_age = 85, .growth_rate = 0.05 }, false);
+
+        ScenarioRunOptions runOptions {
+            .projectionYears = BenchmarkScenarios::ProjectionYears,
+            .numScenarios    = numScenarios,
+            .startDate       = { .month = JANUARY, .year = 2022 },
+            .format          = OutputFormat::BINARY,
+            .batch           = batch,
+            .outputDir       = outputDir
+        };
+
+        long long before = allocationCount();
+
+        generator.generateAllScenarios(runOptions, scenarios.params, scenarios.correlationMatrix);
+
+        long long allocations = allocationCount() - before;
+
+        std::cout.rdbuf(console);
+
+        return allocations;
+    }
+    catch (...)
+    {
+        std::cout.rdbuf(console);
+        throw;
+    }
+}
+
+
+// A whole run allocates its buffers, files and threads up front and then nothing per scenario, so a
+// longer run makes no more allocations than a shorter one
+static bool checkRunAllocations(const BenchmarkOptions& options, const BenchmarkScenarios& scenarios, const string& outputDir, bool batch, bool value, const string& name)
+{
+    constexpr int ShortRun = 64;
+    constexpr int LongRun = 256;
+
+    long long shortAllocations = runAllocations(options, scenarios, outputDir, ShortRun, batch, value);
+    long long longAllocations = runAllocations(options, scenarios, outputDir, LongRun, batch, value);
+
+    std::cout << "  " << name << ": " << shortAllocations << " allocations for " << ShortRun << " scenarios, "
+              << longAllocations << " for " << LongRun << "\n";
+
+    return check(longAllocations == shortAllocations, name + " makes no allocations per scenario");
+}
+
+
+// IntScenario::Generate and FundScenario::Generate reuse their storage from one scenario to the next,
+// and so does a whole run of generateAllScenarios()
+bool runAllocationBenchmark(const BenchmarkOptions& options)
+{
+    BenchmarkScenarios scenarios(options);
+
+    bool passed = checkNoAllocations(scenarios, scenarios.ctx.m_RNG, "mt");
+
+    passed &= checkNoAllocations(scenarios, scenarios.ctx.philoxRNG, "philox");
+    passed &= checkNoAllocations(scenarios, scenarios.ctx.sobolRNG, "sobol");
+
+    // The runs write to a scratch directory, removed afterwards
+    std::filesystem::path outputDir = std::filesystem::temp_directory_path() / "Benchmarks-allocations";
+    std::filesystem::create_directories(outputDir);
+
+    passed &= checkRunAllocations(options, scenarios, (outputDir / "").string(), false, false, "binary run");
+    passed &= checkRunAllocations(options, scenarios, (outputDir / "").string(), true, false, "batched binary run");
+    passed &= checkRunAllocations(options, scenarios, (outputDir / "").string(), false, true, "valued run");
+
+    std::filesystem::remove_all(outputDir);
+
+    return passed;
+}
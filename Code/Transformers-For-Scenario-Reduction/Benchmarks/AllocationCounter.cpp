@@ -0,0 +1,70 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<long long> allocations = 0;
+
+
+long long allocationCount()
+{
+    return allocations.load();
+}
+
+
+static void* allocate(std::size_t size)
+{
+    allocations++;
+
+    if (void* p = std::malloc(size > 0 ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+
+static void* allocateAligned(std::size_t size, std::align_val_t alignment)
+{
+    allocations++;
+
+    // aligned_alloc needs a size that is a multiple of the alignment
+    std::size_t align = static_cast<std::size_t>(alignment);
+    std::size_t rounded = (size + align - 1) / align * align;
+
+#ifdef _MSC_VER
+    void* p = _aligned_malloc(rounded > 0 ? rounded : align, align);
+#else
+    void* p = std::aligned_alloc(align, rounded > 0 ? rounded : align);
+#endif
+
+    if (p)
+        return p;
+
+    throw std::bad_alloc();
+}
+
+
+static void freeAligned(void* p)
+{
+#ifdef _MSC_VER
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+
+void* operator new(std::size_t size)                                { return allocate(size); }
+void* operator new[](std::size_t size)                              { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment)    { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment)  { return allocateAligned(size, alignment); }
+
+void operator delete(void* p) noexcept                              { std::free(p); }
+void operator delete[](void* p) noexcept                            { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept                 { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept               { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept            { freeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept          { freeAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept   { freeAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
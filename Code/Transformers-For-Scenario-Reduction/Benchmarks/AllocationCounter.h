@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+ * Counts the heap allocations made through operator new by the whole program.
+ *
+ * AllocationCounter.cpp replaces the global operator new and delete, so every allocation of a
+ * standard container or an actlib table or vector is counted, including the cache-line aligned
+ * ones.  Take the count before and after the code being checked; the difference is the number of
+ * allocations it made, on any thread.
+ */
+
+long long allocationCount();
@@ -0,0 +1,98 @@
+#include "Benchmark.h"
+
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <vector>
+
+#include "BatchMath.h"
+#include "FundScenarioBatch.h"
+#include "IntScenarioBatch.h"
+
+
+#ifdef SIMD_AVX2
+
+// expAvx2 of NaN in every lane; every lane of the result should be NaN
+TARGET_AVX2 static bool expAvx2KeepsNaN()
+{
+    alignas(32) double out[4];
+
+    _mm256_store_pd(out, batch_math::expAvx2(_mm256_set1_pd(std::numeric_limits<double>::quiet_NaN())));
+
+    return std::isnan(out[0]) && std::isnan(out[1]) && std::isnan(out[2]) && std::isnan(out[3]);
+}
+
+#endif
+
+
+// Generates the same scenarios one at a time and IntScenarioBatch::Lanes at a time, checks that every
+// wealth factor of every fund agrees to 1e-12, and times the two.  The batch path is the one --batch runs:
+// AVX2 where the CPU has it, its scalar fallback otherwise.
+bool runBatchBenchmark(const BenchmarkOptions& options)
+{
+    constexpr int NumScenarios = 32;
+    constexpr double Tolerance = 1e-12;
+
+    BenchmarkScenarios scenarios(options);
+    ScenarioWorkerContext& ctx = scenarios.ctx;
+
+    auto generateBatch = [&](int firstScenario) {
+        ctx.SetEquityVolatilities(scenarios.params.DiversifiedVol, scenarios.params.InternationalVol, scenarios.params.IntermediateVol, scenarios.params.AggressiveVol);
+
+        ctx.intBatch.Generate(firstScenario, IntScenarioBatch::Lanes, nullptr, false, scenarios.initialRateCurve, BenchmarkScenarios::ProjectionYears,
+                              scenarios.params, ctx.m_RNG);
+
+        ctx.fundBatch.Generate(firstScenario, IntScenarioBatch::Lanes, nullptr, false, ctx.intBatch, BenchmarkScenarios::ProjectionYears,
+                               scenarios.correlationFactor, ctx.m_RNG, ctx.DiversifiedFund, ctx.InternationalFund, ctx.IntermediateRiskFund,
+                               ctx.AggressiveFund, ctx.MoneyFund, ctx.IntGovtFund, ctx.LongCorpFund);
+    };
+
+    double maxRelDiff = 0;
+    long compared = 0;
+
+    for (auto first = 1; first <= NumScenarios; first += IntScenarioBatch::Lanes)
+    {
+        generateBatch(first);
+
+        for (auto lane = 0; lane < IntScenarioBatch::Lanes; lane++)
+        {
+            scenarios.generate(first + lane);
+
+            for (auto f = 0; f < FundScenario::NumOutputFunds; f++)
+            {
+                auto scalar = ctx.fundScenario.wealthFactors(f);
+                auto batched = ctx.fundBatch.scenario(lane).wealthFactors(f);
+
+                for (size_t m = 0; m < scalar.size(); m++, compared++)
+                    maxRelDiff = std::max(maxRelDiff, std::abs(batched[m] - scalar[m]) / std::abs(scalar[m]));
+            }
+        }
+    }
+
+    std::cout << "  " << compared << " wealth factors of " << NumScenarios << " scenarios, largest relative difference "
+              << std::scientific << std::setprecision(2) << maxRelDiff << "\n" << std::defaultfloat;
+
+    bool passed = check(maxRelDiff <= Tolerance, "the batch scenarios agree with the scalar ones to 1e-12");
+
+    // exp of NaN must be NaN, not exp of the clamp
+    double nan = std::numeric_limits<double>::quiet_NaN();
+
+    passed &= check(std::isnan(batch_math::expScalar(nan)), "expScalar passes NaN through");
+
+#ifdef SIMD_AVX2
+    if (cpuHasAvx2())
+        passed &= check(expAvx2KeepsNaN(), "expAvx2 passes NaN through");
+#endif
+
+    double scalarSec = secondsPerCall(IntScenarioBatch::Lanes, [&, scenNumber = 0]() mutable { scenarios.generate(++scenNumber); });
+    double batchSec = secondsPerCall(1, [&, scenNumber = 1]() mutable { generateBatch(scenNumber); scenNumber += IntScenarioBatch::Lanes; }) / IntScenarioBatch::Lanes;
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "  scalar " << std::setw(8) << scalarSec * 1e6 << " us per scenario\n"
+              << "  batch  " << std::setw(8) << batchSec * 1e6 << " us per scenario (" << (cpuHasAvx2() ? "AVX2" : "scalar fallback") << ")\n"
+              << std::defaultfloat;
+
+    reportSpeedup(scalarSec, batchSec, 3);
+
+    return passed;
+}
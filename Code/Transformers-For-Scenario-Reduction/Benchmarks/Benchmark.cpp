@@ -0,0 +1,48 @@
+#include "Benchmark.h"
+
+#include <fstream>
+#include <stdexcept>
+
+#include "json.hpp"
+
+#include "ParamFile.h"
+
+
+static json readParamFile(const string& filename)
+{
+    std::ifstream file(filename);
+
+    if (!file)
+        throw std::runtime_error("unable to open parameter file " + filename);
+
+    return json::parse(file);
+}
+
+
+BenchmarkScenarios::BenchmarkScenarios(const BenchmarkOptions& options) :
+    params(readScenarioGeneratorParams(readParamFile(options.paramFile))),
+    correlationMatrix(readCorrelationMatrix(readParamFile(options.paramFile))),
+    correlationFactor(correlationMatrix)
+{
+    constexpr Date April1953 {.month = APRIL, .year = 1953};  // date of the first rate in the per-maturity files
+    constexpr Date StartDate {.month = JANUARY, .year = 2022};  // Scenario-Generator's start date
+
+    if (options.historyFile.empty())
+        histData.LoadMaturityFiles(options.historyDir, April1953);
+    else
+        histData.Load(options.historyFile);
+
+    initialRateCurve = histData.getCurveVecByDate(StartDate);
+
+    ctx.DiversifiedFund      = EquityFundReturn(params.diversified_params);
+    ctx.InternationalFund    = EquityFundReturn(params.international_params);
+    ctx.IntermediateRiskFund = EquityFundReturn(params.intermediate_params);
+    ctx.AggressiveFund       = EquityFundReturn(params.aggressive_params);
+
+    ctx.MoneyFund    = FixedFundReturn(params.money_market);
+    ctx.IntGovtFund  = FixedFundReturn(params.us_intermed_govt);
+    ctx.LongCorpFund = FixedFundReturn(params.us_long_corporate);
+
+    ctx.intScenario.setInterpolation(CurveInterpolation::NELSON_SIEGEL, &histData);
+}
+
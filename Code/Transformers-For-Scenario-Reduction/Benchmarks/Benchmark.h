@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "Vector.h"
+
+#include "C3RNG.h"
+#include "Cholesky.h"
+#include "FundScenario.h"
+#include "HistCurves.h"
+#include "IntScenario.h"
+#include "ScenarioGenerator.h"
+#include "ScenarioGeneratorParams.hpp"
+
+using std::string;
+
+/**
+ * Benchmarks and checks of the scenario generator's kernels, run by name from main().
+ *
+ * Each benchmark prints its timings and returns false if one of its checks fails; the program
+ * exits with 1 if any did.  Timings are the fastest of several rounds, so they show what the
+ * code can do rather than what else the machine was doing.
+ *
+ * Scenarios come from the same parameter file and historical curves as Scenario-Generator,
+ * projected monthly for 100 years.
+ */
+
+struct BenchmarkOptions
+{
+    string paramFile;
+    string historyDir;
+    string historyFile;
+};
+
+
+class BenchmarkScenarios
+{
+public:
+
+    static constexpr int ProjectionYears = 100;
+
+    ScenarioGeneratorParams params;
+    actlib::table<double> correlationMatrix;
+    CholeskyFactor correlationFactor;
+
+    HistCurves histData;
+    actlib::vector<double> initialRateCurve;
+
+    // The fund objects and generators of one worker thread, set up as generateAllScenarios() does
+    ScenarioWorkerContext ctx;
+
+    explicit BenchmarkScenarios(const BenchmarkOptions& options);
+
+    // Generates scenario scenNumber into ctx.intScenario and ctx.fundScenario with the Mersenne Twister
+    void generate(int scenNumber)
+    {
+        generate(scenNumber, ctx.m_RNG);
+    }
+
+    // The same with one of ctx's other generators
+    template <typename Generator>
+    void generate(int scenNumber, Generator& rng)
+    {
+        ctx.SetEquityVolatilities(params.DiversifiedVol, params.InternationalVol, params.IntermediateVol, params.AggressiveVol);
+
+        ctx.intScenario.Generate(scenNumber, nullptr, false, initialRateCurve, ProjectionYears, params, rng);
+
+        ctx.fundScenario.Generate(scenNumber, ctx.intScenario, nullptr, false, ProjectionYears, correlationFactor, rng,
+                                  ctx.DiversifiedFund, ctx.InternationalFund, ctx.IntermediateRiskFund, ctx.AggressiveFund,
+                                  ctx.MoneyFund, ctx.IntGovtFund, ctx.LongCorpFund);
+    }
+};
+
+
+// The mean time of one call to run in seconds, over calls calls, taking the fastest of rounds rounds
+template <typename Run>
+double secondsPerCall(int calls, Run&& run, int rounds = 5)
+{
+    double best = 0;
+
+    for (auto round = 0; round < rounds; round++)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        for (auto i = 0; i < calls; i++)
+            run();
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / calls;
+
+        best = round == 0 ? seconds : std::min(best, seconds);
+    }
+
+    return best;
+}
+
+
+// Prints how many times faster the new code is than the code it replaced, against the speedup asked
+// for.  Timings depend on the machine and compiler, so a missed target is reported, not failed.
+inline void reportSpeedup(double baselineSec, double newSec, double target)
+{
+    double speedup = baselineSec / newSec;
+
+    std::cout << "  speedup " << std::fixed << std::setprecision(2) << speedup << "x (target " << std::setprecision(1) << target << "x, "
+              << (speedup >= target ? "met" : "not met") << ")\n" << std::defaultfloat;
+}
+
+
+// Prints a failed check; returns passed
+inline bool check(bool passed, const string& what)
+{
+    if (!passed)
+        std::cout << "  FAILED: " << what << "\n";
+
+    return passed;
+}
+
+
+bool runJsonBenchmark(const BenchmarkOptions& options);
+bool runAllocationBenchmark(const BenchmarkOptions& options);
+bool runInverseNormalBenchmark(const BenchmarkOptions& options);
+bool runCholeskyBenchmark(const BenchmarkOptions& options);
+bool runHistCurveBenchmark(const BenchmarkOptions& options);
+bool runBatchBenchmark(const BenchmarkOptions& options);
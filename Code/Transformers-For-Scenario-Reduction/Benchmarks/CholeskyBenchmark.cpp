@@ -0,0 +1,74 @@
+#include "Benchmark.h"
+
+#include <iomanip>
+#include <random>
+#include <vector>
+
+#include "Cholesky.h"
+#include "InverseNormal.h"
+
+
+// Correlates one scenario's fund shocks, 11 funds by 1,200 months, with the packed block kernel
+// and with the dense matrix-vector multiply it replaced, and checks the two give the same numbers
+bool runCholeskyBenchmark(const BenchmarkOptions& options)
+{
+    constexpr long NumMonths = 1200;
+    constexpr int Rounds = 200;
+
+    BenchmarkScenarios scenarios(options);
+
+    const CholeskyFactor& factor = scenarios.correlationFactor;
+    const long numVars = factor.size();
+
+    // Shocks stored month by month, numVars per month, as FundScenario draws them
+    std::vector<double> shocks(size_t(numVars * NumMonths));
+    std::mt19937_64 rng(20240601);
+
+    for (auto& z : shocks)
+        z = InverseNormal((double(rng() >> 11) + 0.5) * 0x1.0p-53);
+
+    Cholesky correlator;
+    correlator.setup(factor, NumMonths);
+
+    double blockSec = secondsPerCall(Rounds, [&]() { correlator.correlate(shocks); });
+
+    // The previous kernel: the whole square matrix, upper zeros included, one month at a time
+    std::vector<double> dense(size_t(numVars * numVars), 0.);
+    const double* packed = factor.data();
+
+    for (long var = 0; var < numVars; var++)
+        for (long i = 0; i <= var; i++)
+            dense[var * numVars + i] = *packed++;
+
+    std::vector<double> denseOut(size_t(numVars * NumMonths));
+
+    double denseSec = secondsPerCall(Rounds, [&]() {
+        for (long obs = 0; obs < NumMonths; obs++)
+        {
+            for (long var = 0; var < numVars; var++)
+            {
+                double sum = 0.;
+
+                for (long i = 0; i < numVars; i++)
+                    sum = sum + dense[var * numVars + i] * shocks[obs * numVars + i];
+
+                denseOut[var * NumMonths + obs] = sum;
+            }
+        }
+    });
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "  dense " << std::setw(8) << denseSec * 1e9 / NumMonths << " ns per month\n"
+              << "  block " << std::setw(8) << blockSec * 1e9 / NumMonths << " ns per month\n"
+              << "  speedup " << std::setprecision(2) << denseSec / blockSec << "x\n" << std::defaultfloat;
+
+    long differences = 0;
+
+    for (long var = 0; var < numVars; var++)
+        for (long obs = 0; obs < NumMonths; obs++)
+            differences += correlator.corrNum(var, obs) != denseOut[var * NumMonths + obs];
+
+    std::cout << "  " << differences << " of " << numVars * NumMonths << " correlated shocks differ\n";
+
+    return check(differences == 0, "the block kernel gives the same correlated shocks as the dense multiply");
+}
@@ -0,0 +1,84 @@
+#include "Benchmark.h"
+
+#include <iomanip>
+#include <random>
+#include <vector>
+
+
+// Checks that the k-d tree over the historical curves returns the same best fitting curve as the
+// scan, times both, and compares the cost of historical and Nelson-Siegel curve interpolation
+bool runHistCurveBenchmark(const BenchmarkOptions& options)
+{
+    constexpr int NumQueries = 200'000;
+    constexpr int NumScenarios = 50;
+
+    BenchmarkScenarios scenarios(options);
+    const HistCurves& hist = scenarios.histData;
+
+    // Queries are historical (1, 7, 20 year) points moved by up to half the spread of the rates,
+    // so they cover the curves, the gaps between them, and points outside the history
+    std::vector<double> queries(3 * size_t(NumQueries));
+    std::mt19937_64 rng(20240601);
+    std::uniform_int_distribution<int> pickCurve(1, hist.getNumCurves());
+    std::uniform_real_distribution<double> jitter(-0.05, 0.05);
+
+    for (int q = 0; q < NumQueries; q++)
+    {
+        int curve = pickCurve(rng);
+        bool exact = q % 10 == 0;  // some queries sit exactly on a historical curve
+
+        queries[3 * q]     = hist.histCurveRateByIndex(curve, 3) + (exact ? 0 : jitter(rng));
+        queries[3 * q + 1] = hist.histCurveRateByIndex(curve, 7) + (exact ? 0 : jitter(rng));
+        queries[3 * q + 2] = hist.histCurveRateByIndex(curve, 9) + (exact ? 0 : jitter(rng));
+    }
+
+    bool passed = true;
+
+    for (int fitMethod : { 1, 2 })
+    {
+        std::vector<int> indexed(NumQueries), scanned(NumQueries);
+
+        double indexSec = secondsPerCall(1, [&]() {
+            for (int q = 0; q < NumQueries; q++)
+                indexed[q] = hist.BestFittingCurve(queries[3 * q], queries[3 * q + 1], queries[3 * q + 2], fitMethod);
+        }, 3);
+
+        double scanSec = secondsPerCall(1, [&]() {
+            for (int q = 0; q < NumQueries; q++)
+                scanned[q] = hist.BestFittingCurveScan(queries[3 * q], queries[3 * q + 1], queries[3 * q + 2], fitMethod);
+        }, 3);
+
+        int differences = 0;
+
+        for (int q = 0; q < NumQueries; q++)
+            differences += indexed[q] != scanned[q];
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << "  fit method " << fitMethod << ": index " << indexSec * 1e6 / NumQueries << " us, scan "
+                  << scanSec * 1e6 / NumQueries << " us per query over " << hist.getNumCurves() << " curves; "
+                  << differences << " of " << NumQueries << " answers differ\n" << std::defaultfloat;
+
+        passed &= check(differences == 0, "the index finds the same curve as the scan");
+    }
+
+    // Interest rate scenarios alone, where the interpolation is done
+    auto secondsPerScenario = [&](CurveInterpolation method) {
+        scenarios.ctx.intScenario.setInterpolation(method, &hist);
+
+        return secondsPerCall(NumScenarios, [&, scenNumber = 0]() mutable {
+            scenarios.ctx.intScenario.Generate(++scenNumber, nullptr, false, scenarios.initialRateCurve, BenchmarkScenarios::ProjectionYears,
+                                               scenarios.params, scenarios.ctx.m_RNG);
+        }, 3);
+    };
+
+    double nsSec = secondsPerScenario(CurveInterpolation::NELSON_SIEGEL);
+    double histSec = secondsPerScenario(CurveInterpolation::HISTORICAL);
+
+    scenarios.ctx.intScenario.setInterpolation(CurveInterpolation::NELSON_SIEGEL, &hist);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "  interest rate scenario of 1,200 months: Nelson-Siegel " << nsSec * 1e6 << " us, historical " << histSec * 1e6 << " us ("
+              << std::showpos << (histSec / nsSec - 1) * 100 << std::noshowpos << "%)\n" << std::defaultfloat;
+
+    return passed;
+}
@@ -0,0 +1,70 @@
+#include "Benchmark.h"
+
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "InverseNormal.h"
+
+
+// Converts 10 million uniforms to normals one at a time and with the batch API, checks the
+// batch results are bit-identical to the scalar ones and that bad input is rejected
+bool runInverseNormalBenchmark(const BenchmarkOptions&)
+{
+    constexpr size_t NumDraws = 10'000'000;
+
+    std::vector<double> uniforms(NumDraws);
+    std::mt19937_64 rng(20240601);
+
+    // Top 53 bits offset by half a step, as Philox draws them, so neither 0 nor 1 occurs
+    for (auto& u : uniforms)
+        u = (double(rng() >> 11) + 0.5) * 0x1.0p-53;
+
+    std::vector<double> scalar(NumDraws), batch(NumDraws);
+
+    double scalarSec = secondsPerCall(1, [&]() {
+        for (size_t i = 0; i < NumDraws; i++)
+            scalar[i] = InverseNormal(uniforms[i]);
+    });
+
+    double batchSec = secondsPerCall(1, [&]() { InverseNormal(uniforms, batch); });
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "  scalar " << std::setw(8) << scalarSec * 1e9 / NumDraws << " ns per draw, " << std::setprecision(3) << scalarSec << " s for 10M\n"
+              << std::setprecision(1)
+              << "  batch  " << std::setw(8) << batchSec * 1e9 / NumDraws << " ns per draw, " << std::setprecision(3) << batchSec << " s for 10M\n"
+              << "  speedup " << std::setprecision(2) << scalarSec / batchSec << "x\n" << std::defaultfloat;
+
+    size_t differences = 0;
+
+    for (size_t i = 0; i < NumDraws; i++)
+        differences += std::memcmp(&scalar[i], &batch[i], sizeof(double)) != 0;
+
+    std::cout << "  " << differences << " of 10M results differ from the scalar function\n";
+
+    bool passed = check(differences == 0, "the batch results are bit-identical to the scalar function");
+
+    for (double bad : { 0., 1., -0.5, std::nan("") })
+    {
+        std::vector<double> in(8, 0.5), out(8);
+        in[5] = bad;
+
+        bool rejected = false;
+
+        try
+        {
+            InverseNormal(in, out);
+        }
+        catch (const std::out_of_range&)
+        {
+            rejected = true;
+        }
+
+        passed &= check(rejected, "the batch API rejects " + std::to_string(bad));
+    }
+
+    return passed;
+}
@@ -0,0 +1,122 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "JsonBuffer.h"
+
+
+// The serializer JsonBuffer replaced: std::to_string for every value, appended to a growing string
+static string serializeWithToString(const FundScenario& fundScenario)
+{
+    auto fundToString = [&](int fund) -> string
+    {
+        string s;
+
+        s += "\"" + FundScenario::fundName(fund) + "\"";
+        s += ":";
+        s += "[";
+
+        for (int month = 1; month < fundScenario.getNumMonths(); month++)
+            s += std::to_string(fundScenario.totalReturn(month, fund)) + ",";
+
+        s += std::to_string(fundScenario.totalReturn(fundScenario.getNumMonths(), fund));
+        s += "]";
+
+        return s;
+    };
+
+    string json = "{";
+
+    for (int fund = 0; fund < FundScenario::NumOutputFunds - 1; fund++)
+    {
+        json += fundToString(fund);
+        json += ",\n";
+    }
+
+    json += fundToString(FundScenario::NumOutputFunds - 1);
+    json += "}";
+
+    return json;
+}
+
+
+// Reads back the numbers of the JsonBuffer output and checks they are the scenario's returns exactly
+static bool roundTrips(const FundScenario& fundScenario, std::string_view json)
+{
+    int fund = 0, month = 1;
+    const char* p = json.data();
+    const char* end = json.data() + json.size();
+
+    while ((p = std::find(p, end, '[')) != end)
+    {
+        for (month = 1; ; month++)
+        {
+            double value;
+            auto [next, ec] = std::from_chars(p + 1, end, value);
+
+            if (ec != std::errc() || value != fundScenario.totalReturn(month, fund))
+                return false;
+
+            p = next;
+
+            if (*p == ']')
+                break;
+        }
+
+        if (month != fundScenario.getNumMonths())
+            return false;
+
+        fund++;
+    }
+
+    return fund == FundScenario::NumOutputFunds;
+}
+
+
+// Serializes a 1,200 month scenario with the old to_string serializer and with JsonBuffer
+bool runJsonBenchmark(const BenchmarkOptions& options)
+{
+    BenchmarkScenarios scenarios(options);
+    scenarios.generate(1);
+
+    const FundScenario& fundScenario = scenarios.ctx.fundScenario;
+
+    JsonBuffer buffer;
+    size_t toStringSize = 0;
+
+    double toStringSec = secondsPerCall(50, [&]() { toStringSize = serializeWithToString(fundScenario).size(); });
+
+    double bufferSec = secondsPerCall(50, [&]() {
+        buffer.clear();
+        fundScenario.serializeToJson(buffer);
+    });
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "  std::to_string  " << std::setw(10) << toStringSec * 1e6 << " us per scenario, " << toStringSize << " bytes\n"
+              << "  JsonBuffer      " << std::setw(10) << bufferSec * 1e6 << " us per scenario, " << buffer.size() << " bytes\n" << std::defaultfloat;
+
+    reportSpeedup(toStringSec, bufferSec, 5);
+
+    bool passed = check(roundTrips(fundScenario, buffer.view()), "the JSON numbers read back as the scenario's returns");
+
+    bool rejected = false;
+
+    try
+    {
+        buffer.putNumber(std::nan(""));
+    }
+    catch (const std::domain_error&)
+    {
+        rejected = true;
+    }
+
+    passed &= check(rejected, "a NaN is rejected rather than written as null, which the GMIB reader cannot parse");
+
+    return passed;
+}
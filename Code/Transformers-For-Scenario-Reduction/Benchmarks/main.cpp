@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "argparse.hpp"
+
+#include "Benchmark.h"
+
+using std::string;
+using std::vector;
+
+
+struct BenchmarkArgs : public argparse::Args
+{
+    string& param_file   = kwarg("param_file", "file with parameters for scenario generator").set_default("Scn-Gen-params.json");
+    string& history_dir  = kwarg("history_dir", "directory holding the historical yield curves, one file per maturity (0.25.csv ... 30.csv)").set_default("C:\\Users\\scott\\source\\repos\\Scenario-Generator\\Historic-Curves\\");
+    string& history_file = kwarg("history_file", "consolidated historical yield curve file (.csv, or .bin for binary); used instead of --history_dir").set_default("");
+    string& only         = kwarg("only", "comma separated names of the benchmarks to run; all of them by default").set_default("");
+};
+
+
+struct Benchmark
+{
+    string name;
+    string description;
+    bool (*run)(const BenchmarkOptions&);
+};
+
+
+int main(int argc, char** argv)
+{
+    auto args = argparse::parse<BenchmarkArgs>(argc, argv);
+
+    const vector<Benchmark> benchmarks {
+        { "json", "serialize a 1,200 month scenario to JSON", runJsonBenchmark },
+        { "allocations", "count heap allocations while generating scenarios", runAllocationBenchmark },
+        { "inverse_normal", "convert 10 million uniforms to normals", runInverseNormalBenchmark },
+        { "cholesky", "correlate 11 x 1,200 fund shocks", runCholeskyBenchmark },
+        { "hist_curves", "find the best fitting historical curve", runHistCurveBenchmark },
+        { "batch", "generate scenarios four at a time against one at a time", runBatchBenchmark },
+    };
+
+    vector<string> names;
+    std::istringstream only(args.only);
+
+    for (string name; std::getline(only, name, ','); )
+    {
+        if (std::none_of(benchmarks.begin(), benchmarks.end(), [&](const Benchmark& b) { return b.name == name; }))
+            throw std::invalid_argument("unknown benchmark " + name);
+
+        names.push_back(name);
+    }
+
+    BenchmarkOptions options {
+        .paramFile   = args.param_file,
+        .historyDir  = args.history_dir,
+        .historyFile = args.history_file
+    };
+
+    int failures = 0;
+
+    for (const auto& benchmark : benchmarks)
+    {
+        if (!names.empty() && std::find(names.begin(), names.end(), benchmark.name) == names.end())
+            continue;
+
+        std::cout << benchmark.name << ": " << benchmark.description << "\n";
+
+        if (!benchmark.run(options))
+            failures++;
+
+        std::cout << "\n";
+    }
+
+    if (failures > 0)
+    {
+        std::cout << failures << " benchmark" << (failures > 1 ? "s" : "") << " failed\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -9,4 +9,23 @@ enum class FundType
     MONEY_MARKET,
     GOVT_INTERMEDIATE,
     CORPORATE_LONG
-};
\ No newline at end of file
+};
+
+constexpr int NUM_FUND_TYPES = 7;
+
+// Name of the fund in the scenario files
+constexpr const char* fund_type_name(FundType fund)
+{
+    switch (fund)
+    {
+    case FundType::DIVERSIFIED:       return "USDiversified";
+    case FundType::INTERNATIONAL:     return "International";
+    case FundType::INTERMEDIATE:      return "Intermediate";
+    case FundType::AGGRESSIVE:        return "Aggressive";
+    case FundType::MONEY_MARKET:      return "MoneyMkt";
+    case FundType::GOVT_INTERMEDIATE: return "MedGovt";
+    case FundType::CORPORATE_LONG:    return "LongCorp";
+
+    default: throw;
+    }
+}
@@ -0,0 +1,109 @@
+#include "PolicyProjection.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+#include "FundType.h"
+
+
+PolicyProjection::PolicyProjection(const vector<int>& rider_terms, const vector<double>& deposits, double growth_rate, int num_months) :
+    num_policies(int(rider_terms.size())),
+    order(rider_terms.size()),
+    slot(rider_terms.size()),
+    deposits(deposits)
+{
+    if (deposits.size() != rider_terms.size())
+        throw std::invalid_argument("PolicyProjection: one deposit is needed per policy");
+
+    for (auto term : rider_terms)
+    {
+        if (term < 0 || term * 12 > num_months)
+            throw std::out_of_range("a rider term of " + std::to_string(term) + " years does not fit in scenarios of " + std::to_string(num_months) + " months");
+    }
+
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return rider_terms[a] > rider_terms[b]; });
+
+    term_months.resize(num_policies);
+    guarantee_factors.resize(num_policies);
+    initial_fund_values.resize(NUM_FUND_TYPES * num_policies);
+
+    for (auto i = 0; i < num_policies; i++)
+    {
+        int p = order[i];
+
+        slot[p] = i;
+        term_months[i] = rider_terms[p] * 12;
+        guarantee_factors[i] = pow((1 + growth_rate), rider_terms[p]);
+
+        for (auto f = 0; f < NUM_FUND_TYPES; f++)
+            initial_fund_values[f * num_policies + i] = deposits[p] / NUM_FUND_TYPES;
+    }
+}
+
+
+void PolicyProjection::add_cashflows(const Scenario& s, Workspace& ws, vector<double>& cashflows) const
+{
+    const int n = num_policies;
+
+    const double* returns[NUM_FUND_TYPES];
+
+    for (auto f = 0; f < NUM_FUND_TYPES; f++)
+        returns[f] = s.get_fund_returns(FundType(f));
+
+    ws.fund_values.assign(initial_fund_values.begin(), initial_fund_values.end());
+    ws.account_values.assign(n, 0.);
+    ws.initial_values.assign(n, 0.);
+
+    for (auto f = 0; f < NUM_FUND_TYPES; f++)
+        for (auto i = 0; i < n; i++)
+            ws.initial_values[i] += ws.fund_values[f * n + i];
+
+    ws.max_values.assign(ws.initial_values.begin(), ws.initial_values.end());
+
+    // The account is rolled forward through months 1 to term - 1 of each policy
+    int active = n;
+
+    for (auto m = 1; active > 0; m++)
+    {
+        while (active > 0 && term_months[active - 1] <= m)
+            active--;
+
+        double* account = ws.account_values.data();
+
+        std::fill(account, account + active, 0.);
+
+        for (auto f = 0; f < NUM_FUND_TYPES; f++)
+        {
+            double growth = 1 + returns[f][m];
+            double* values = ws.fund_values.data() + f * n;
+
+            for (auto i = 0; i < active; i++)
+            {
+                values[i] *= growth;
+                account[i] += values[i];
+            }
+        }
+
+        double* max_values = ws.max_values.data();
+
+        for (auto i = 0; i < active; i++)
+            max_values[i] = std::max(max_values[i], account[i]);
+    }
+
+    // The ratchet, or the deposit rolled up at the guaranteed rate if that is higher
+    for (auto i = 0; i < n; i++)
+        ws.account_values[i] = std::max(ws.max_values[i], ws.initial_values[i] * guarantee_factors[i]);
+
+    // Added policy by policy in the original order so the sums come out the same
+    for (auto p = 0; p < n; p++)
+    {
+        int i = slot[p];
+
+        cashflows.at(0) = deposits[p];
+        cashflows.at(term_months[i]) += ws.account_values[i];
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+
+#include "Scenario.h"
+
+using std::vector;
+
+/**
+ * Projects the fund accounts of a block of policies through a scenario all at once.
+ *
+ * Rather than a FundAccount per policy, rolled forward month by month with every month's
+ * account value kept to find the highest one for the GMIB ratchet, the fund values of all
+ * the policies are held fund by fund (fund_values[fund * num_policies + policy]), each
+ * month's return of a fund is applied to every policy in one pass, and only the running
+ * maximum of each account is kept.
+ *
+ * The policies are stored longest rider term first, so the policies still in force in a month
+ * are always the first ones and the inner loops run over a contiguous range.
+ *
+ * Every account value is worked out with the same operations in the same order as
+ * FundAccount::rollforward_funds_this_month() and the maturity value as
+ * calculate_gmib_maturity_value(), so the cashflows are bit-identical to projecting each
+ * policy with them.
+ */
+
+class PolicyProjection
+{
+    int num_policies;
+
+    vector<int> order;          // order[i] is the original index of the policy stored i-th
+    vector<int> slot;           // slot[p] is where policy p is stored
+    vector<int> term_months;    // rider term in months, longest first
+    vector<double> initial_fund_values;  // [fund][policy], the deposit split evenly over the funds
+    vector<double> deposits;             // by original policy index
+    vector<double> guarantee_factors;    // (1 + growth rate)^rider term, by stored policy
+
+public:
+
+    // Scratch space for one projection; one per thread, reused from scenario to scenario
+    struct Workspace
+    {
+        vector<double> fund_values;     // [fund][policy]
+        vector<double> account_values;  // this month's total, by stored policy
+        vector<double> max_values;      // highest total so far, by stored policy
+        vector<double> initial_values;  // total at issue, by stored policy
+    };
+
+    // rider_terms are in years; a scenario must cover the longest of them
+    PolicyProjection(const vector<int>& rider_terms, const vector<double>& deposits, double growth_rate, int num_months);
+
+    // Sets cashflows[0] to the deposit and adds each policy's GMIB maturity value at the end of
+    // its rider term, adding them policy by policy in the original order
+    void add_cashflows(const Scenario& s, Workspace& ws, vector<double>& cashflows) const;
+};
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+using json = nlohmann::json;
+using std::string;
+using std::vector;
+
+/**
+ * Summary statistics of the scenario PVs, updated one PV at a time as the scenarios are valued.
+ *
+ * The mean and variance are kept with Welford's update.  VaR and CTE only depend on the worst
+ * scenarios, the ones with the highest PV of guarantee payments, so only the largest PVs are
+ * kept: enough of them for the lowest level asked for.  With levels of 70 and up that is at most
+ * 30% of the scenarios, held in a min-heap, and the figures are exact rather than estimated.
+ *
+ * At a level of a percent, the tail is the worst (100 - a)% of the n scenarios, at least one.
+ * CTE(a) is the mean PV of the tail and VaR(a) is the highest PV outside it.
+ */
+
+class PvStatistics
+{
+    vector<double> levels;
+    vector<int> tail_counts;  // scenarios in the tail at each level
+    int num_scenarios;
+
+    long count = 0;
+    double mean = 0;
+    double sum_sq = 0;  // sum of squared deviations from the mean
+
+    std::priority_queue<double, vector<double>, std::greater<double>> largest;
+    size_t max_kept = 0;
+
+public:
+
+    // levels are percentages, e.g. 99 for VaR(99); num_scenarios is the number of PVs that will be added
+    PvStatistics(const vector<double>& levels, int num_scenarios) :
+        levels(levels),
+        num_scenarios(num_scenarios)
+    {
+        for (auto level : levels)
+        {
+            if (!(level > 0 && level < 100))
+                throw std::invalid_argument("VaR and CTE levels must be between 0 and 100, not " + std::to_string(level));
+
+            // The small allowance stops (100 - 90) / 100 * 1000 from rounding down to 99
+            int tail = std::max(1, int((100 - level) / 100 * num_scenarios + 1e-9));
+
+            tail_counts.push_back(tail);
+
+            // VaR needs the highest PV outside the tail as well
+            max_kept = std::max(max_kept, size_t(tail) + 1);
+        }
+
+        // Room for every PV kept, so add() never has to grow the heap
+        vector<double> storage;
+        storage.reserve(max_kept);
+        largest = decltype(largest)(std::greater<double>(), std::move(storage));
+    }
+
+    void add(double pv)
+    {
+        count++;
+
+        double delta = pv - mean;
+        mean += delta / count;
+        sum_sq += delta * (pv - mean);
+
+        if (largest.size() < max_kept)
+            largest.push(pv);
+        else if (pv > largest.top())
+        {
+            largest.pop();
+            largest.push(pv);
+        }
+    }
+
+    struct Tail
+    {
+        double level;
+        double var;
+        double cte;
+    };
+
+    // VaR and CTE at each level, once all num_scenarios PVs have been added
+    _NODISCARD vector<Tail> tails() const
+    {
+        if (count != num_scenarios)
+            throw std::logic_error("PvStatistics: " + std::to_string(count) + " PVs were added, " + std::to_string(num_scenarios) + " were expected");
+
+        vector<double> worst;
+        worst.reserve(largest.size());
+
+        for (auto heap = largest; !heap.empty(); heap.pop())
+            worst.push_back(heap.top());
+
+        std::reverse(worst.begin(), worst.end());  // highest first
+
+        vector<Tail> result;
+
+        if (worst.empty())
+            return result;
+
+        for (size_t i = 0; i < levels.size(); i++)
+        {
+            int tail = std::min(tail_counts[i], int(worst.size()));
+
+            double sum = 0;
+
+            for (auto j = 0; j < tail; j++)
+                sum += worst[j];
+
+            // With every scenario in the tail there is nothing outside it; report the lowest PV
+            double var = tail < int(worst.size()) ? worst[tail] : worst.back();
+
+            result.push_back({ levels[i], var, sum / tail });
+        }
+
+        return result;
+    }
+
+    _NODISCARD long size() const     { return count; }
+    _NODISCARD double mean_pv() const { return mean; }
+
+    _NODISCARD double std_dev() const
+    {
+        return count > 1 ? sqrt(sum_sq / (count - 1)) : 0;
+    }
+
+    void print() const
+    {
+        if (count == 0)
+            return;
+
+        std::cout << "PV statistics (" << count << " scenarios)\n";
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "mean " << mean_pv() << ", standard deviation " << std_dev() << "\n";
+        std::cout << std::setw(8) << "level" << std::setw(18) << "VaR" << std::setw(18) << "CTE" << "\n";
+
+        for (const auto& t : tails())
+            std::cout << std::setw(8) << std::setprecision(1) << t.level << std::setprecision(2) << std::setw(18) << t.var << std::setw(18) << t.cte << "\n";
+
+        std::cout << std::defaultfloat;
+    }
+
+    _NODISCARD json to_json() const
+    {
+        json result = { { "num_scenarios", count }, { "mean", mean_pv() }, { "std_dev", std_dev() } };
+
+        for (const auto& t : tails())
+        {
+            std::ostringstream level;
+            level << t.level;
+
+            result["var"][level.str()] = t.var;
+            result["cte"][level.str()] = t.cte;
+        }
+
+        return result;
+    }
+};
+
+
+// Parses a comma separated list of levels such as "70,90,99"
+inline _NODISCARD vector<double> parse_levels(const string& text)
+{
+    vector<double> levels;
+    std::istringstream in(text);
+    string item;
+
+    while (std::getline(in, item, ','))
+    {
+        if (!item.empty())
+            levels.push_back(std::stod(item));
+    }
+
+    return levels;
+}
@@ -1,5 +1,6 @@
 #include "Scenario.h"
 
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -29,3 +30,47 @@ Scenario::Scenario(const json& data, int num_months) :
     LongCorpFund         (FundReturns(get_returns(data, num_months, "LongCorp")))
 {
 }
+
+
+FundReturns get_returns(const ScenarioFileReader& reader, int scenario_num, int num_months, string fund_name)
+{
+    if (num_months > reader.num_months())
+        throw std::out_of_range("scenario file has fewer months than requested");
+
+    return FundReturns(reader.fund_returns(scenario_num, reader.fund_index(fund_name)), num_months);
+}
+
+Scenario::Scenario(const ScenarioFileReader& reader, int scenario_num, int num_months) :
+    DiversifiedFund      (get_returns(reader, scenario_num, num_months, "USDiversified")),
+    InternationalFund    (get_returns(reader, scenario_num, num_months, "International")),
+    AggressiveFund       (get_returns(reader, scenario_num, num_months, "Aggressive")),
+    IntermediateRiskFund (get_returns(reader, scenario_num, num_months, "Intermediate")),
+    MoneyFund            (get_returns(reader, scenario_num, num_months, "MoneyMkt")),
+    IntGovtFund          (get_returns(reader, scenario_num, num_months, "MedGovt")),
+    LongCorpFund         (get_returns(reader, scenario_num, num_months, "LongCorp"))
+{
+}
+
+
+Scenario::Scenario(const double* returns, int num_months) :
+    DiversifiedFund      (returns + int(FundType::DIVERSIFIED) * num_months, num_months),
+    InternationalFund    (returns + int(FundType::INTERNATIONAL) * num_months, num_months),
+    IntermediateRiskFund (returns + int(FundType::INTERMEDIATE) * num_months, num_months),
+    AggressiveFund       (returns + int(FundType::AGGRESSIVE) * num_months, num_months),
+    MoneyFund            (returns + int(FundType::MONEY_MARKET) * num_months, num_months),
+    IntGovtFund          (returns + int(FundType::GOVT_INTERMEDIATE) * num_months, num_months),
+    LongCorpFund         (returns + int(FundType::CORPORATE_LONG) * num_months, num_months)
+{
+}
+
+
+void Scenario::assign(const double* returns, int num_months)
+{
+    DiversifiedFund.assign(returns + int(FundType::DIVERSIFIED) * num_months, num_months);
+    InternationalFund.assign(returns + int(FundType::INTERNATIONAL) * num_months, num_months);
+    IntermediateRiskFund.assign(returns + int(FundType::INTERMEDIATE) * num_months, num_months);
+    AggressiveFund.assign(returns + int(FundType::AGGRESSIVE) * num_months, num_months);
+    MoneyFund.assign(returns + int(FundType::MONEY_MARKET) * num_months, num_months);
+    IntGovtFund.assign(returns + int(FundType::GOVT_INTERMEDIATE) * num_months, num_months);
+    LongCorpFund.assign(returns + int(FundType::CORPORATE_LONG) * num_months, num_months);
+}
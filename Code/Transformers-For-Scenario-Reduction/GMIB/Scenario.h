@@ -4,6 +4,7 @@
 
 #include "json.hpp"
 #include "FundType.h"
+#include "ScenarioFileReader.h"
 
 using json = nlohmann::json;
 using std::vector;
@@ -14,6 +15,8 @@ class FundReturns
 
 public:
 
+    FundReturns() = default;
+
     explicit FundReturns(const vector<double>& r) :
         returns(r)
     {}
@@ -22,10 +25,26 @@ public:
         returns(std::move(r))
     {}
 
+    FundReturns(const double* r, int num_months) :
+        returns(r, r + num_months)
+    {}
+
+    // Replaces the returns, reusing the storage when it is large enough
+    void assign(const double* r, int num_months)
+    {
+        returns.assign(r, r + num_months);
+    }
+
     [[nodiscard]] double get_return(int month) const
     {
         return returns[month];
     }
+
+    // The monthly returns, contiguous from month 0
+    [[nodiscard]] const double* data() const
+    {
+        return returns.data();
+    }
 };
 
 
@@ -43,6 +62,14 @@ public:
 
     Scenario() = default;
     Scenario(const json &data, int num_months);
+    Scenario(const ScenarioFileReader& reader, int scenario_num, int num_months);
+
+    // returns holds num_months returns of each fund, one fund after another in FundType order
+    // (the layout of a scenario block in a binary scenario file)
+    Scenario(const double* returns, int num_months);
+
+    // Refills the scenario from returns laid out as above, without allocating once it has held a scenario as long
+    void assign(const double* returns, int num_months);
 
     [[nodiscard]] double get_monthly_return(FundType fund, int month) const
     {
@@ -59,5 +86,22 @@ public:
         default: throw;
         }
     }
+
+    // Contiguous monthly returns of one fund, for loops over months that look the fund up once
+    [[nodiscard]] const double* get_fund_returns(FundType fund) const
+    {
+        switch (fund)
+        {
+        case FundType::DIVERSIFIED:       return DiversifiedFund.data();
+        case FundType::INTERNATIONAL:     return InternationalFund.data();
+        case FundType::INTERMEDIATE:      return IntermediateRiskFund.data();
+        case FundType::AGGRESSIVE:        return AggressiveFund.data();
+        case FundType::MONEY_MARKET:      return MoneyFund.data();
+        case FundType::GOVT_INTERMEDIATE: return IntGovtFund.data();
+        case FundType::CORPORATE_LONG:    return LongCorpFund.data();
+
+        default: throw;
+        }
+    }
 };
 
@@ -0,0 +1,140 @@
+#include "ScenarioFileReader.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+ScenarioFileReader::ScenarioFileReader(const string& filename)
+{
+#ifdef _WIN32
+    fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+        fileHandle = nullptr;
+        throw std::runtime_error("unable to open scenario file " + filename);
+    }
+
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(fileHandle, &fileSize);
+    size = static_cast<size_t>(fileSize.QuadPart);
+
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (mappingHandle != nullptr)
+        base = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        throw std::runtime_error("unable to open scenario file " + filename);
+
+    struct stat st;
+    fstat(fd, &st);
+    size = static_cast<size_t>(st.st_size);
+
+    void* mapping = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+
+    if (mapping != MAP_FAILED)
+    {
+        base = static_cast<const char*>(mapping);
+        madvise(mapping, size, MADV_SEQUENTIAL);
+    }
+#endif
+
+    if (base == nullptr)
+    {
+        unmap();
+        throw std::runtime_error("unable to map scenario file " + filename);
+    }
+
+    if (size < sizeof(ScenarioFileHeader))
+    {
+        unmap();
+        throw std::runtime_error("scenario file " + filename + " is truncated");
+    }
+
+    std::memcpy(&header, base, sizeof(header));
+
+    if (std::memcmp(header.magic, SCENARIO_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != SCENARIO_FILE_VERSION)
+    {
+        unmap();
+        throw std::runtime_error(filename + " is not a scenario file this version can read");
+    }
+
+    if (size < scenario_file_size(header))
+    {
+        unmap();
+        throw std::runtime_error("scenario file " + filename + " is truncated");
+    }
+}
+
+
+ScenarioFileReader::~ScenarioFileReader()
+{
+    unmap();
+}
+
+
+void ScenarioFileReader::unmap()
+{
+#ifdef _WIN32
+    if (base != nullptr)          UnmapViewOfFile(base);
+    if (mappingHandle != nullptr) CloseHandle(mappingHandle);
+    if (fileHandle != nullptr)    CloseHandle(fileHandle);
+
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    if (base != nullptr)
+        munmap(const_cast<char*>(base), size);
+#endif
+
+    base = nullptr;
+}
+
+
+string ScenarioFileReader::fund_name(int fund) const
+{
+    if (fund < 0 || fund >= num_funds())
+        throw std::out_of_range("fund index out of range");
+
+    const char* name = base + sizeof(ScenarioFileHeader) + fund * SCENARIO_FILE_FUND_NAME_LEN;
+
+    return string(name, strnlen(name, SCENARIO_FILE_FUND_NAME_LEN));
+}
+
+
+int ScenarioFileReader::fund_index(const string& fund_name) const
+{
+    for (auto f = 0; f < num_funds(); f++)
+    {
+        if (this->fund_name(f) == fund_name)
+            return f;
+    }
+
+    throw std::out_of_range("fund " + fund_name + " is not in the scenario file");
+}
+
+
+const double* ScenarioFileReader::fund_returns(int scenario_num, int fund) const
+{
+    if (scenario_num < 1 || scenario_num > num_scenarios() || fund < 0 || fund >= num_funds())
+        throw std::out_of_range("scenario or fund index out of range");
+
+    const char* block = base + scenario_block_offset(header, scenario_num);
+
+    return reinterpret_cast<const double*>(block) + size_t(fund) * num_months();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "ScenarioFile.h"
+
+using std::string;
+
+/**
+ * Read-only view of a binary scenario file written by the Scenario-Generator (see ScenarioFile.h).
+ *
+ * The whole file is memory-mapped when the reader is constructed, so looking up the returns for
+ * a scenario is just pointer arithmetic into the mapping and pages are only read from disk as
+ * the scenarios are used.
+ */
+
+class ScenarioFileReader
+{
+    const char* base = nullptr;
+    size_t size = 0;
+    ScenarioFileHeader header {};
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+
+    void unmap();
+
+public:
+
+    explicit ScenarioFileReader(const string& filename);
+    ~ScenarioFileReader();
+
+    ScenarioFileReader(const ScenarioFileReader&) = delete;
+    ScenarioFileReader& operator=(const ScenarioFileReader&) = delete;
+
+    [[nodiscard]] int num_funds() const     { return header.numFunds; }
+    [[nodiscard]] int num_months() const    { return header.numMonths; }
+    [[nodiscard]] int num_scenarios() const { return header.numScenarios; }
+
+    [[nodiscard]] string fund_name(int fund) const;
+    [[nodiscard]] int fund_index(const string& fund_name) const;
+
+    // Pointer to the num_months() contiguous monthly returns of one fund in one scenario (scenario numbers start at 1)
+    [[nodiscard]] const double* fund_returns(int scenario_num, int fund) const;
+};
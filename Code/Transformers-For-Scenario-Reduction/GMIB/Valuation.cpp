@@ -0,0 +1,284 @@
+#include "Valuation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+
+// Discounted account value each policy would reach at the end of its rider term with no guarantee.
+// wealth_factor(fund, months) gives the growth of a fund over the first months of the scenario.
+double discounted_account_value(const ValuationParams& params, const PolicyInfo& policy_info, auto wealth_factor)
+{
+    double value = 0;
+
+    for (const auto& policy : policy_info.policies)
+    {
+        int term_months = (params.maturity_age - policy.age) * 12;
+
+        double account_value = 0;
+
+        for (auto f = 0; f < NUM_FUND_TYPES; f++)
+            account_value += params.dep_amount / NUM_FUND_TYPES * wealth_factor(FundType(f), term_months);
+
+        value += account_value * pow(1 + params.discount_rate, -term_months / 12.);
+    }
+
+    return value;
+}
+
+
+// The control variate for a scenario
+double control_value(const ValuationParams& params, const PolicyInfo& policy_info, const Scenario& s)
+{
+    return discounted_account_value(params, policy_info, [&](FundType fund, int months) {
+        double wealth_factor = 1;
+
+        for (auto m = 0; m < months; m++)
+            wealth_factor *= 1 + s.get_monthly_return(fund, m);
+
+        return wealth_factor;
+    });
+}
+
+
+// The known expectation of the control variate
+double control_value(const ValuationParams& params, const PolicyInfo& policy_info, const ExpectedWealthFactors& expected_wealth)
+{
+    return discounted_account_value(params, policy_info, [&](FundType fund, int months) {
+        return expected_wealth.factor(fund, months);
+    });
+}
+
+
+vector<double> discount_curve(double discount_rate, int num_months)
+{
+    vector<double> discount_factors (num_months + 1);
+
+    double monthly_discount_factor = pow(1 + discount_rate, -1./12.);
+
+    double v = 1;
+
+    std::generate(discount_factors.begin(), discount_factors.end(), [&]() {
+        v *= monthly_discount_factor;
+        return v;
+    });
+
+    return discount_factors;
+}
+
+
+double pv_of_cashflows(const vector<double>& cashflows, const vector<double>& discount_factors)
+{
+    if (discount_factors.size() < cashflows.size())
+        throw std::invalid_argument("the discount curve is shorter than the cashflows");
+
+    auto reduce = std::plus<double> {};
+    auto transform = std::multiplies<double> {};
+
+    return std::transform_reduce(cashflows.begin(), cashflows.end(), discount_factors.begin(), 0., reduce, transform);
+}
+
+
+void write_pv(std::ostream& outfile, double pv_cf, int scenario_num, bool use_comma_separator)
+{
+    // Fixed with 6 decimals as std::to_string() formats it, without building a string for each scenario
+    char pv_text[400];
+    const char* end = std::to_chars(pv_text, pv_text + sizeof(pv_text), pv_cf, std::chars_format::fixed, 6).ptr;
+
+    outfile << "{\"scenario_number\": " << scenario_num << ", \"pv_cf\": " << std::string_view(pv_text, end - pv_text) << " }" << (use_comma_separator ? ",\n" : "\n");
+}
+
+
+// The model policies for PolicyProjection
+PolicyProjection project_policies(const ValuationParams& params, const PolicyInfo& policy_info)
+{
+    vector<int> rider_terms;
+    vector<double> deposits;
+
+    for (const auto& policy : policy_info.policies)
+    {
+        rider_terms.push_back(params.maturity_age - policy.age);
+        deposits.push_back(params.dep_amount);
+    }
+
+    return PolicyProjection(rider_terms, deposits, params.growth_rate, params.num_months);
+}
+
+
+PortfolioValuation::PortfolioValuation(const ValuationParams& params, const string& out_dir, int num_scenarios) :
+    params(params),
+    num_scenarios(num_scenarios),
+    out_dir(out_dir),
+    projection(project_policies(params, policy_info)),
+    discount_factors(discount_curve(params.discount_rate, params.num_months)),
+    statistics(params.levels, num_scenarios),
+    variance_report(params.antithetic)
+{
+    if (params.write_results)
+    {
+        outfile.open(out_dir + "result.json", std::ios::out | std::ios::trunc);
+
+        if (!outfile)
+            throw std::runtime_error("unable to create output file " + out_dir + "result.json");
+
+        outfile << "[\n";
+    }
+
+    if (!params.pv_file.empty())
+    {
+        pv_dump.open(params.pv_file, std::ios::out | std::ios::trunc | std::ios::binary);
+
+        if (!pv_dump)
+            throw std::runtime_error("unable to create PV file " + params.pv_file);
+    }
+
+    if (!params.control_means.empty())
+        control_mean = control_value(params, policy_info, ExpectedWealthFactors(params.control_means, params.num_months));
+}
+
+
+PortfolioValuation::ScenarioValue PortfolioValuation::evaluate(const Scenario& s, Workspace& ws) const
+{
+    ws.cashflows.assign(params.num_months + 1, 0);
+
+    projection.add_cashflows(s, ws.projection, ws.cashflows);
+
+    ScenarioValue value{ .pv = pv_of_cashflows(ws.cashflows, discount_factors), .control = 0 };
+
+    if (control_mean)
+        value.control = control_value(params, policy_info, s);
+
+    return value;
+}
+
+
+void PortfolioValuation::record(int scenario_num, const ScenarioValue& value)
+{
+    if (outfile.is_open())
+        write_pv(outfile, value.pv, scenario_num, scenario_num != num_scenarios);
+
+    if (pv_dump.is_open())
+        pv_dump.write(reinterpret_cast<const char*>(&value.pv), sizeof(double));
+
+    statistics.add(value.pv);
+    variance_report.add(value.pv, value.control);
+}
+
+
+void PortfolioValuation::value_scenario(int scenario_num, const Scenario& s)
+{
+    record(scenario_num, evaluate(s, workspace));
+}
+
+
+void PortfolioValuation::value_all_scenarios(int num_threads, const std::function<Scenario(int)>& load_scenario)
+{
+    std::atomic<int> next_scenario = 1;
+
+    // Scenarios valued ahead of the next one to record wait here; guarded by results_mutex
+    std::mutex results_mutex;
+    map<int, ScenarioValue> pending;
+    int next_to_record = 1;
+    std::exception_ptr error;
+
+    // Progress is reported every progress_interval scenarios recorded, and printed after results_mutex is released
+    constexpr int progress_interval = 100;
+
+    auto worker = [&]() {
+        Workspace thread_workspace;
+
+        for (int i = next_scenario++; i <= num_scenarios; i = next_scenario++)
+        {
+            try
+            {
+                ScenarioValue value = evaluate(load_scenario(i), thread_workspace);
+                int progress = 0;
+
+                {
+                    std::lock_guard lock(results_mutex);
+
+                    pending.emplace(i, value);
+
+                    while (!pending.empty() && pending.begin()->first == next_to_record)
+                    {
+                        record(next_to_record, pending.begin()->second);
+                        pending.erase(pending.begin());
+
+                        if (next_to_record % progress_interval == 0 || next_to_record == num_scenarios)
+                            progress = next_to_record;
+
+                        next_to_record++;
+                    }
+                }
+
+                if (progress)
+                    std::cout << "valued " << progress << " of " << num_scenarios << " scenarios\n";
+            }
+            catch (...)
+            {
+                std::lock_guard lock(results_mutex);
+
+                if (!error)
+                    error = std::current_exception();
+
+                // Stop handing out scenarios; the other threads finish the one they are on
+                next_scenario = num_scenarios + 1;
+            }
+        }
+    };
+
+    if (num_threads <= 1)
+    {
+        worker();
+    }
+    else
+    {
+        vector<std::thread> threads;
+
+        for (auto t = 0; t < num_threads; t++)
+            threads.emplace_back(worker);
+
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+
+void PortfolioValuation::finish()
+{
+    if (outfile.is_open())
+    {
+        outfile << "]";
+        outfile.close();
+    }
+
+    if (pv_dump.is_open())
+    {
+        pv_dump.close();
+
+        if (!pv_dump)
+            throw std::runtime_error("unable to write PV file " + params.pv_file);
+    }
+
+    variance_report.print(control_mean);
+
+    statistics.print();
+
+    std::ofstream statistics_file(out_dir + "statistics.json", std::ios::out | std::ios::trunc);
+
+    if (!statistics_file)
+        throw std::runtime_error("unable to create output file " + out_dir + "statistics.json");
+
+    statistics_file << statistics.to_json().dump(4) << "\n";
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <fstream>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "PolicyProjection.h"
+#include "PvStatistics.h"
+#include "Scenario.h"
+#include "VarianceReduction.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+/**
+ * Values the GMIB riders of a block of policies over a set of scenarios.
+ *
+ * The scenarios are passed to value_scenario() one at a time and in scenario order, whether they
+ * are read from scenario files (GMIB main) or handed over straight from the Scenario-Generator
+ * (its --value mode).  The PV of each scenario's cashflows is written to result.json and,
+ * if asked for, as a raw double to a PV file.  finish() prints the variance report and the PV
+ * statistics, and writes the statistics to statistics.json.
+ *
+ * value_all_scenarios() values the scenarios on several threads.  Each scenario is valued on
+ * one thread with that thread's own scratch space, and the results are recorded in scenario
+ * order, so result.json and the report are the same whatever the number of threads.
+ */
+
+struct ValuationParams
+{
+    int num_months      = 0;        // months of each scenario used
+    int maturity_age    = 10;       // age when the rider matures
+    double growth_rate  = 0.0;      // compound growth rate of the guarantee
+    double dep_amount   = 100'000;  // deposit per policy
+    double discount_rate = 0.05;
+    bool antithetic     = false;    // the scenarios are antithetic pairs
+    string control_means;           // file of expected wealth factors for the control variate, or empty
+    vector<double> levels { 70, 90, 99 };  // VaR and CTE levels, in percent
+    bool write_results  = true;     // write each scenario's PV to result.json
+    string pv_file;                 // file for each scenario's PV as a double, in scenario order, or empty
+};
+
+
+struct PolicyInfo
+{
+    map<int, double> age_distribution { { 20, 0.10 },
+                                        { 25, 0.10 },
+                                        { 30, 0.10 },
+                                        { 35, 0.10 },
+                                        { 40, 0.10 },
+                                        { 45, 0.10 },
+                                        { 50, 0.10 },
+                                        { 55, 0.10 },
+                                        { 60, 0.10 },
+                                        { 65, 0.10 } };
+
+    map<char, double> gender_distribution { { 'm', 0.50 },
+                                            { 'f', 0.50 }};
+
+    struct Policy
+    {
+        int age;
+        char gender;
+        double weight;
+    };
+
+    vector<Policy> policies;
+
+    PolicyInfo()
+    {
+        policies.reserve(age_distribution.size() * gender_distribution.size());
+
+        for (auto age : age_distribution)
+            for (auto gender : gender_distribution)
+                policies.push_back( {age.first, gender.first, age.second * gender.second });
+    }
+};
+
+
+// discount_factors[m] is applied to the cashflow of month m: (1 + discount_rate)^-((m + 1) / 12)
+vector<double> discount_curve(double discount_rate, int num_months);
+
+double pv_of_cashflows(const vector<double>& cashflows, const vector<double>& discount_factors);
+
+void write_pv(std::ostream& outfile, double pv_cf, int scenario_num, bool use_comma_separator);
+
+
+class PortfolioValuation
+{
+    ValuationParams params;
+    int num_scenarios;
+    string out_dir;
+
+    PolicyInfo policy_info;
+    PolicyProjection projection;
+    vector<double> discount_factors;  // worked out once for every scenario
+
+    std::ofstream outfile;  // result.json
+    std::ofstream pv_dump;
+    PvStatistics statistics;
+
+    // The control variate needs the expected wealth factors; without them only the antithetic estimate is reported
+    std::optional<double> control_mean;
+
+    VarianceReport variance_report;
+
+    // Scratch space for valuing a scenario, reused from one scenario to the next
+    struct Workspace
+    {
+        vector<double> cashflows;
+        PolicyProjection::Workspace projection;
+    };
+
+    Workspace workspace;  // used by value_scenario()
+
+    struct ScenarioValue
+    {
+        double pv;
+        double control;  // only set with a control mean
+    };
+
+    // Only reads the members set up by the constructor, so any number of threads may call it
+    ScenarioValue evaluate(const Scenario& s, Workspace& ws) const;
+
+    // Writes the scenario's PV and adds it to the statistics and the variance report; called in scenario order
+    void record(int scenario_num, const ScenarioValue& value);
+
+public:
+
+    // Creates result.json in out_dir, and the PV file if params name one
+    PortfolioValuation(const ValuationParams& params, const string& out_dir, int num_scenarios);
+
+    // Scenarios must be valued in order, starting from 1
+    void value_scenario(int scenario_num, const Scenario& s);
+
+    // Values scenarios 1 to num_scenarios on num_threads threads.  load_scenario is called
+    // from those threads, once per scenario.
+    void value_all_scenarios(int num_threads, const std::function<Scenario(int)>& load_scenario);
+
+    // Closes the output files, prints the variance report and the PV statistics, and writes statistics.json to out_dir
+    void finish();
+};
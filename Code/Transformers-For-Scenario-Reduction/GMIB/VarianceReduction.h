@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+#include "FundType.h"
+
+using json = nlohmann::json;
+using std::string;
+using std::vector;
+
+/**
+ * Standard errors of the PV estimate, with and without variance reduction.
+ *
+ * Antithetic scenarios come in mirrored pairs (scenarios 2k-1 and 2k, see the
+ * Scenario-Generator --antithetic flag).  The two PVs of a pair are not independent,
+ * so the pair average is the sampling unit and its variance gives the standard error.
+ *
+ * The control variate is a value computed from each scenario whose expectation is known
+ * exactly.  Its observed error in a scenario set predicts part of the error in the PVs,
+ * and the estimate is corrected by beta times that error, with beta fitted by least squares.
+ * The correction is unbiased only if the supplied expectation is the true one.
+ */
+
+class ExpectedWealthFactors
+{
+    std::array<vector<double>, NUM_FUND_TYPES> factors;  // factors[fund][m] is the expected wealth factor after m months
+
+public:
+
+    // The file maps each fund name to either an array of expected wealth factors for months 1, 2, ...
+    // or to a single number, the expected wealth factor after one year, which is compounded monthly
+    ExpectedWealthFactors(const string& filename, int num_months)
+    {
+        std::ifstream file(filename);
+
+        if (!file)
+            throw std::runtime_error("cannot open expected wealth factor file " + filename);
+
+        json data = json::parse(file);
+
+        for (auto f = 0; f < NUM_FUND_TYPES; f++)
+        {
+            string name = fund_type_name(FundType(f));
+
+            if (!data.contains(name))
+                throw std::invalid_argument("expected wealth factor file has no entry for " + name);
+
+            vector<double>& fund_factors = factors[f];
+            fund_factors.assign(num_months + 1, 1.);
+
+            if (data[name].is_number())
+            {
+                double annual_factor = data[name];
+
+                for (auto m = 1; m <= num_months; m++)
+                    fund_factors[m] = pow(annual_factor, m / 12.);
+            }
+            else
+            {
+                if (data[name].size() < num_months)
+                    throw std::invalid_argument("expected wealth factor file has fewer months than requested for " + name);
+
+                for (auto m = 1; m <= num_months; m++)
+                    fund_factors[m] = data[name][m - 1];
+            }
+        }
+    }
+
+    _NODISCARD double factor(FundType fund, int month) const
+    {
+        return factors[int(fund)].at(month);
+    }
+};
+
+
+struct EstimateSummary
+{
+    double mean;
+    double std_error;
+};
+
+
+namespace variance_reduction_detail
+{
+    // Running means of y and x and sums of products of their deviations from the means, updated as in Welford's algorithm
+    struct CoMoments
+    {
+        long n = 0;
+        double mean_y = 0;
+        double mean_x = 0;
+        double syy = 0;
+        double sxx = 0;
+        double sxy = 0;
+
+        void add(double y, double x)
+        {
+            n++;
+
+            double dy = y - mean_y;
+            double dx = x - mean_x;
+
+            mean_y += dy / n;
+            mean_x += dx / n;
+
+            syy += dy * (y - mean_y);
+            sxx += dx * (x - mean_x);
+            sxy += dy * (x - mean_x);
+        }
+    };
+}
+
+
+/**
+ * The variance report, worked out as the scenarios are valued so that their PVs need not be kept.
+ *
+ * Each scenario's PV and control value go into running sums, and with antithetic scenarios so
+ * do the averages of each pair once its second scenario arrives.  Scenarios must be added in
+ * scenario order so that the pairs line up.
+ */
+
+class VarianceReport
+{
+    bool antithetic;
+
+    variance_reduction_detail::CoMoments scenarios;  // PV and control value of each scenario
+    variance_reduction_detail::CoMoments pairs;      // the same averaged over each antithetic pair
+
+    double first_pv = 0;       // first scenario of the pair still waiting for its second
+    double first_control = 0;
+
+    // The sampling units are the scenarios, or the antithetic pairs when antithetic is set
+    const variance_reduction_detail::CoMoments& units() const
+    {
+        return antithetic ? pairs : scenarios;
+    }
+
+    static EstimateSummary plain_estimate(const variance_reduction_detail::CoMoments& m)
+    {
+        return { m.mean_y, sqrt(m.syy / (m.n - 1) / m.n) };
+    }
+
+    EstimateSummary control_variate_estimate(double control_mean, double& beta) const
+    {
+        const auto& m = units();
+
+        beta = m.sxx > 0 ? m.sxy / m.sxx : 0;
+
+        // The sum of squared residuals after the correction; one degree of freedom goes to fitting beta
+        double residual = std::max(0., m.syy - 2 * beta * m.sxy + beta * beta * m.sxx) / (m.n - 2);
+
+        return { m.mean_y - beta * (m.mean_x - control_mean), sqrt(residual / m.n) };
+    }
+
+public:
+
+    explicit VarianceReport(bool antithetic) :
+        antithetic(antithetic)
+    {
+    }
+
+    // control is only used when print() is given a control mean
+    void add(double pv, double control)
+    {
+        scenarios.add(pv, control);
+
+        if (!antithetic)
+            return;
+
+        if (scenarios.n % 2 == 1)
+        {
+            first_pv = pv;
+            first_control = control;
+        }
+        else
+            pairs.add(0.5 * (first_pv + pv), 0.5 * (first_control + control));
+    }
+
+    // Prints the PV estimate and its standard error for each method, with the gain in effective sample size over plain Monte Carlo
+    void print(std::optional<double> control_mean) const
+    {
+        if (scenarios.n < 4)
+        {
+            std::cout << "Variance report skipped: at least 4 scenarios are needed\n";
+            return;
+        }
+
+        if (antithetic && scenarios.n % 2 != 0)
+            throw std::invalid_argument("antithetic scenarios come in pairs, so the number of scenarios must be even");
+
+        EstimateSummary plain = plain_estimate(scenarios);
+        double n = double(scenarios.n);
+
+        auto print_row = [&](const string& name, EstimateSummary e) {
+            double gain = e.std_error > 0 ? (plain.std_error * plain.std_error) / (e.std_error * e.std_error) : 0;
+
+            std::cout << std::setw(22) << std::left << name << std::right
+                      << std::setw(18) << std::fixed << std::setprecision(2) << e.mean
+                      << std::setw(16) << e.std_error
+                      << std::setw(10) << std::setprecision(3) << gain
+                      << std::setw(14) << std::setprecision(0) << n * gain << "\n";
+        };
+
+        std::cout << "PV variance report (" << scenarios.n << " scenarios)\n";
+        std::cout << std::setw(22) << std::left << "estimator" << std::right << std::setw(18) << "mean PV" << std::setw(16) << "std error" << std::setw(10) << "ESS gain" << std::setw(14) << "effective n" << "\n";
+
+        print_row("plain Monte Carlo", plain);
+
+        if (antithetic)
+            print_row("antithetic pairs", plain_estimate(pairs));
+
+        if (control_mean)
+        {
+            double beta;
+            EstimateSummary cv = control_variate_estimate(*control_mean, beta);
+
+            print_row(antithetic ? "antithetic + control" : "control variate", cv);
+            std::cout << "control variate beta = " << std::setprecision(4) << beta << ", control mean = " << std::setprecision(2) << *control_mean << "\n";
+        }
+
+        std::cout << std::defaultfloat;
+    }
+};
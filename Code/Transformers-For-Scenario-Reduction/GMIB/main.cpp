@@ -3,15 +3,17 @@
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <numeric>
+#include <optional>
 #include <string>
 #include <vector>
 #include "argparse.hpp"
 #include "json.hpp"
 
-#include "FundAccount.h"
-#include "GuarMinIncomeBenefit.h"
 #include "Scenario.h"
+#include "ScenarioFileReader.h"
+#include "Valuation.h"
 
 using std::ifstream;
 using std::ofstream;
@@ -40,7 +42,14 @@ struct InputArgs : public argparse::Args
     int& maturity_age   = kwarg("maturity_age", "age when the rider matures").set_default(10);
     double& growth_rate = kwarg("growth_rate", "compound growth rate").set_default(0.0);
     double& dep_amount  = kwarg("deposit", "deposit amount").set_default(100'000);
+    string& format      = kwarg("format", "scenario file format, 'json' or 'binary'").set_default("json");
+    bool& antithetic    = flag("antithetic", "the scenarios are antithetic pairs (Scenario-Generator --antithetic)").set_default(false);
+    string& control_means = kwarg("control_means", "file of expected wealth factors by fund, used for the control variate").set_default("");
     string& param_file  = kwarg("p,params", "parameter file").set_default("");
+    int& num_threads    = kwarg("threads,t", "number of threads; the results do not depend on it").set_default(1);
+    string& levels      = kwarg("levels", "comma separated VaR and CTE levels, in percent").set_default("70,90,99");
+    string& pv_file     = kwarg("pv_file", "also write each scenario's PV to this file, as doubles in scenario order").set_default("");
+    bool& no_result_json = flag("no_result_json", "do not write the per-scenario PVs to result.json").set_default(false);
 
     static InputArgs get_args(int argc, char** argv)
     {
@@ -78,6 +87,17 @@ struct InputArgs : public argparse::Args
             add_param("maturity_age");
             add_param("growth_rate");
             add_param("deposit");
+            add_param("format");
+            add_param("control_means");
+            add_param("threads");
+            add_param("levels");
+            add_param("pv_file");
+
+            if (data.contains("antithetic") && bool(data["antithetic"]))
+                shadow_params.push_back("--antithetic");
+
+            if (data.contains("no_result_json") && bool(data["no_result_json"]))
+                shadow_params.push_back("--no_result_json");
 
             for (auto& p : shadow_params)
                 params.push_back(p.c_str());
@@ -89,95 +109,6 @@ struct InputArgs : public argparse::Args
 };
 
 
-struct PolicyInfo
-{
-    map<int, double> age_distribution { { 20, 0.10 },
-                                        { 25, 0.10 },
-                                        { 30, 0.10 },
-                                        { 35, 0.10 },
-                                        { 40, 0.10 },
-                                        { 45, 0.10 },
-                                        { 50, 0.10 },
-                                        { 55, 0.10 },
-                                        { 60, 0.10 },
-                                        { 65, 0.10 } };
-
-    map<char, double> gender_distribution { { 'm', 0.50 },
-                                            { 'f', 0.50 }};
-
-    struct Policy
-    {
-        int age;
-        char gender;
-        double weight;
-    };
-
-    vector<Policy> policies;
-
-    PolicyInfo()
-    {
-        policies.reserve(age_distribution.size() * gender_distribution.size());
-
-        for (auto age : age_distribution)
-            for (auto gender : gender_distribution)
-                policies.push_back( {age.first, gender.first, age.second * gender.second });
-    }
-};
-
-
-vector<double> run_single_policy_single_scenario(vector<double>& cashflows, const InputArgs& args, const PolicyInfo::Policy& policy, short num_months, const Scenario& s)
-{
-    FundAccount f;
-
-    int rider_term = args.maturity_age - policy.age;
-
-    GMIB_Params gmib_params{ .rider_term = rider_term, .compound_growth_rate = args.growth_rate };
-
-    double deposit_amount = args.dep_amount;
-
-    vector<double> historical_values;
-
-    f.add_deposit(deposit_amount);
-    historical_values.push_back(f.get_total_fund_value());
-    cashflows.at(0) = deposit_amount;
-
-    for (auto i = 1; i < gmib_params.rider_term * 12; i++)
-    {
-        f.rollforward_funds_this_month(i, s);
-
-        historical_values.push_back(f.get_total_fund_value());
-    }
-
-    double gmib_value = calculate_gmib_maturity_value(gmib_params, historical_values);
-    cashflows.at(gmib_params.rider_term * 12) += gmib_value;
-
-    return cashflows;
-}
-
-
-
-void write_pv_of_cashflows(ofstream& outfile, const vector<double>& cashflows, double discount_rate, int scenario_num, bool use_comma_separator)
-{
-    vector<double> discount_factors (cashflows.size());
-
-    double monthly_discount_factor = pow(1 + discount_rate, -1./12.);
-
-    double v = 1;
-
-    std::generate(discount_factors.begin(), discount_factors.end(), [&]() {
-        v *= monthly_discount_factor;
-        return v;
-    });
-
-    auto reduce = std::plus<double> {};
-    auto transform = std::multiplies<double> {};
-
-    double pv_cf = std::transform_reduce(cashflows.begin(), cashflows.end(), discount_factors.begin(), 0., reduce, transform);
-
-    outfile << "{\"scenario_number\": " << scenario_num << ", \"pv_cf\": " << std::to_string(pv_cf) << " }" << (use_comma_separator ? ",\n" : "\n");
-}
-
-
 int main(int argc, char** argv)
 {
     auto args = InputArgs::get_args(argc, argv);
@@ -186,42 +117,50 @@ int main(int argc, char** argv)
 
     try
     {
-        ofstream outfile(args.out_dir + "result.json", std::ios::out | std::ios::trunc);
-        outfile << "[\n";
-
         // Save the start time for use when later determining total elapsed time.
         auto StartTime = std::chrono::system_clock::now();
 
-        for (auto i = 1; i <= args.num_scenarios; i++)
-        {
-            std::cout << "processing scenario " << i << std::endl;
+        // A binary scenario file is mapped once up front instead of opening a file per scenario
+        std::unique_ptr<ScenarioFileReader> reader;
+
+        if (args.format == "binary")
+            reader = std::make_unique<ScenarioFileReader>(args.in_dir + SCENARIO_FILE_NAME);
+        else if (args.format != "json")
+            throw std::invalid_argument("unknown scenario file format " + args.format);
+
+        ValuationParams params{ .num_months = args.num_period, .maturity_age = args.maturity_age, .growth_rate = args.growth_rate,
+                                .dep_amount = args.dep_amount, .antithetic = args.antithetic, .control_means = args.control_means,
+                                .levels = parse_levels(args.levels), .write_results = !args.no_result_json, .pv_file = args.pv_file };
+
+        PortfolioValuation valuation(params, args.out_dir, args.num_scenarios);
+
+        const int num_months = args.num_period;
+
+        // Called from the valuation threads; the binary file reader is read-only once opened
+        auto load_scenario = [&](int i) {
+            if (reader)
+                return Scenario(*reader, i, num_months);
 
             string scenario_filename = args.in_dir + "scenario_" + std::to_string(i) + ".json";
 
             ifstream scenario_file(scenario_filename);
             json data = json::parse(scenario_file);
 
-            const int num_months = args.num_period;
+            return Scenario(data, num_months);
+        };
 
-            Scenario s(data, num_months);
+        valuation.value_all_scenarios(args.num_threads, load_scenario);
 
-            vector<double> cashflows(num_months + 1, 0);
-
-            for (auto policy : PolicyInfo().policies)
-            {
-                run_single_policy_single_scenario(cashflows, args, policy, num_months, s);
-            }
-
-            double discount_rate = 0.05;
-            write_pv_of_cashflows(outfile, cashflows, discount_rate, i, i != args.num_scenarios);
-        }     
-        
         auto dEndTime = std::chrono::system_clock::now();
 
         std::cout << "Processing time = " << std::chrono::duration_cast<std::chrono::seconds>(dEndTime - StartTime).count() << " seconds" << std::endl;
 
-        outfile << "]";
-        outfile.close();
+        valuation.finish();
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "error: " << e.what() << std::endl;
+        return -1;
     }
     catch (...)
     {
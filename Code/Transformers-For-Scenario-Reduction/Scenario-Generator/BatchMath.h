@@ -0,0 +1,116 @@
+#pragma once
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+#include "CpuFeatures.h"
+
+/**
+ * Elementary functions for the batch kernels, in a scalar and an AVX2 version.
+ *
+ * The batch kernels (IntScenarioBatch, FundScenarioBatch) advance several scenarios in
+ * lockstep, one per lane.  Each scenario still draws its own random numbers from its own
+ * seed, and every lane goes through the same operations whatever the other lanes hold, so a
+ * scenario's results do not depend on which scenarios share its batch.  CPUs without AVX2
+ * run the same operations one lane at a time and get bit-identical results.
+ *
+ * The two versions do the same operations in the same order, so each lane of the AVX2
+ * version gives exactly the scalar result and a kernel's fallback for CPUs without AVX2
+ * reproduces its vector results.  No FMA is used because fusing would change the rounding.
+ * Results differ from the C library by about one unit in the last place.
+ */
+
+namespace batch_math
+{
+    // exp(x) = 2^n * exp(r) with x = n ln2 + r and |r| <= ln2 / 2.  ln2 is split so that n * Ln2Hi is exact.
+    constexpr double Log2e = 1.44269504088896338700e+00;
+    constexpr double Ln2Hi = 6.93147180369123816490e-01;
+    constexpr double Ln2Lo = 1.90821492927058770002e-10;
+
+    // Arguments are clamped so that 2^n stays a normal double.  NaN is not clamped and gives NaN.
+    constexpr double ExpArgMax = 700;
+    constexpr double ExpArgMin = -700;
+
+    // Taylor series of exp(r) to r^13: ExpCoeffs[k] = 1 / k!.  The first omitted term is below 1e-17 of the result.
+    constexpr double ExpCoeffs[] = {
+        1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040,
+        1.0 / 40320, 1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800, 1.0 / 479001600, 1.0 / 6227020800
+    };
+
+
+    // Written as the vector min and max, which return the second operand if either is NaN
+    inline double maxScalar(double a, double b)
+    {
+        return a > b ? a : b;
+    }
+
+
+    inline double minScalar(double a, double b)
+    {
+        return a < b ? a : b;
+    }
+
+
+    inline double expScalar(double x)
+    {
+        // x goes second so that a NaN argument is kept
+        x = minScalar(ExpArgMax, x);
+        x = maxScalar(ExpArgMin, x);
+
+        // Converting NaN to an integer for 2^n is undefined; the vector version gives NaN from p
+        if (std::isnan(x))
+            return x;
+
+        double n = std::nearbyint(x * Log2e);
+        double r = (x - n * Ln2Hi) - n * Ln2Lo;
+
+        // Estrin's scheme: pairs of terms, then pairs of pairs, so the chain of dependent operations is short
+        double r2 = r * r;
+        double r4 = r2 * r2;
+        double r8 = r4 * r4;
+
+        double q[7];
+
+        for (int k = 0; k < 7; k++)
+            q[k] = ExpCoeffs[2 * k] + ExpCoeffs[2 * k + 1] * r;
+
+        double s0 = (q[0] + q[1] * r2) + (q[2] + q[3] * r2) * r4;
+        double s1 = (q[4] + q[5] * r2) + q[6] * r4;
+        double p = s0 + s1 * r8;
+
+        return p * std::bit_cast<double>(uint64_t(int64_t(n) + 1023) << 52);
+    }
+
+
+#ifdef SIMD_AVX2
+
+    INLINE_AVX2 __m256d expAvx2(__m256d x)
+    {
+        x = _mm256_min_pd(_mm256_set1_pd(ExpArgMax), x);
+        x = _mm256_max_pd(_mm256_set1_pd(ExpArgMin), x);
+
+        __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(Log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256d r = _mm256_sub_pd(_mm256_sub_pd(x, _mm256_mul_pd(n, _mm256_set1_pd(Ln2Hi))), _mm256_mul_pd(n, _mm256_set1_pd(Ln2Lo)));
+
+        __m256d r2 = _mm256_mul_pd(r, r);
+        __m256d r4 = _mm256_mul_pd(r2, r2);
+        __m256d r8 = _mm256_mul_pd(r4, r4);
+
+        __m256d q[7];
+
+        for (int k = 0; k < 7; k++)
+            q[k] = _mm256_add_pd(_mm256_set1_pd(ExpCoeffs[2 * k]), _mm256_mul_pd(_mm256_set1_pd(ExpCoeffs[2 * k + 1]), r));
+
+        __m256d s0 = _mm256_add_pd(_mm256_add_pd(q[0], _mm256_mul_pd(q[1], r2)), _mm256_mul_pd(_mm256_add_pd(q[2], _mm256_mul_pd(q[3], r2)), r4));
+        __m256d s1 = _mm256_add_pd(_mm256_add_pd(q[4], _mm256_mul_pd(q[5], r2)), _mm256_mul_pd(q[6], r4));
+        __m256d p = _mm256_add_pd(s0, _mm256_mul_pd(s1, r8));
+
+        __m256i exponent = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n));
+        __m256d scale = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(exponent, _mm256_set1_epi64x(1023)), 52));
+
+        return _mm256_mul_pd(p, scale);
+    }
+
+#endif
+}
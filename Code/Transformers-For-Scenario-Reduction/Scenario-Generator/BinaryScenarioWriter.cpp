@@ -0,0 +1,57 @@
+#include "BinaryScenarioWriter.h"
+
+#include <filesystem>
+#include <stdexcept>
+
+
+void BinaryScenarioWriter::createFile(const string& filename, int numMonths, int numScenarios)
+{
+    ScenarioFileHeader fileHeader = make_scenario_file_header(FundScenario::NumOutputFunds, numMonths, numScenarios);
+
+    std::ofstream out(filename, std::ios::out | std::ios::trunc | std::ios::binary);
+
+    if (!out)
+        throw std::runtime_error("unable to create scenario file " + filename);
+
+    out.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+
+    for (auto fund = 0; fund < FundScenario::NumOutputFunds; fund++)
+    {
+        char name[SCENARIO_FILE_FUND_NAME_LEN] = {};
+        FundScenario::fundName(fund).copy(name, SCENARIO_FILE_FUND_NAME_LEN - 1);
+
+        out.write(name, SCENARIO_FILE_FUND_NAME_LEN);
+    }
+
+    out.close();
+
+    // Reserve a slot for every scenario up front so the workers can write them in any order
+    std::filesystem::resize_file(filename, scenario_file_size(fileHeader));
+}
+
+
+void BinaryScenarioWriter::open(const string& filename)
+{
+    file.open(filename, std::ios::in | std::ios::out | std::ios::binary);
+
+    if (!file)
+        throw std::runtime_error("unable to open scenario file " + filename);
+
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    buffer.resize(header.numFunds * header.numMonths);
+}
+
+
+void BinaryScenarioWriter::write(int scenarioNumber, const FundScenario& fundScenario)
+{
+    if (uint32_t(fundScenario.getNumMonths()) != header.numMonths || scenarioNumber < 1 || uint32_t(scenarioNumber) > header.numScenarios)
+        throw std::out_of_range("scenario does not fit the scenario file");
+
+    // Same values as the JSON output: the total return for months 1..numMonths, one fund after another
+    for (auto fund = 0; fund < FundScenario::NumOutputFunds; fund++)
+        fundScenario.totalReturns(fund, buffer.data() + fund * header.numMonths);
+
+    file.seekp(scenario_block_offset(header, scenarioNumber));
+    file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(double));
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ScenarioFile.h"
+#include "FundScenario.h"
+
+using std::string;
+using std::vector;
+
+/**
+ * This class writes fund scenarios into a single binary scenario file (see ScenarioFile.h).
+ *
+ * createFile() is called once before generation starts.  It writes the header and sizes the file
+ * so that every scenario has a fixed slot.  Each worker thread then opens its own writer on the
+ * same file and writes each scenario straight into its slot, so the threads never need to
+ * coordinate and the file contents do not depend on the order scenarios finish in.
+ */
+
+class BinaryScenarioWriter
+{
+    std::fstream file;
+    ScenarioFileHeader header {};
+    vector<double> buffer;   // one scenario block, reused for every scenario this writer writes
+
+public:
+
+    static void createFile(const string& filename, int numMonths, int numScenarios);
+
+    void open(const string& filename);
+
+    bool isOpen() const
+    {
+        return file.is_open();
+    }
+
+    void write(int scenarioNumber, const FundScenario& fundScenario);
+};
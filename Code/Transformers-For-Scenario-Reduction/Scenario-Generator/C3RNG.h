@@ -1,9 +1,20 @@
 #pragma once
 
+#include <cstdint>
 #include <random>
+#include <span>
 
+#include "InverseNormal.h"
 #include "Vector.h"
 
+// The independent random processes drawn for each scenario
+enum class RandomStream
+{
+    InterestRates,
+    FundReturns
+};
+
+
 class C3RNG
 {
     actlib::vector<double> mStateArray;
@@ -50,8 +61,179 @@ public:
         gen64.seed(nSeed);
     }
 
+    // Seeds used since the first version: the scenario number offset by 200 for rates and 10200 for funds
+    void Seed(int scenNumber, RandomStream stream)
+    {
+        Reseed(scenNumber - 1 + (stream == RandomStream::InterestRates ? 200 : 10200));
+    }
+
     double GetNext()
     {
         return distribution(gen64);
     }
-};
\ No newline at end of file
+
+    void Fill(std::span<double> out)
+    {
+        for (auto& u : out)
+            u = GetNext();
+    }
+
+    // Standard normal shocks, numProcesses per month; for a pseudo-random generator the layout does not matter
+    void FillNormals(std::span<double> out, [[maybe_unused]] int numProcesses)
+    {
+        Fill(out);
+        InverseNormal(out, out);
+    }
+};
+
+
+/**
+ * Philox4x32-10 counter-based generator (Salmon et al., "Parallel random numbers:
+ * as easy as 1, 2, 3", SC11).
+ *
+ * Each block of random bits is a pure function of a key and a counter.  The key is
+ * (scenario number, random stream), so every scenario and process has its own stream
+ * with no chance of two streams overlapping, and seeding costs nothing.  The counter
+ * is the position in the stream, so Seek() jumps to any draw in constant time; with a
+ * fixed number of draws per month, draw j of month m is at m * drawsPerMonth + j.
+ *
+ * Each block gives two doubles in (0, 1) with 53 random bits each.
+ */
+
+class Philox
+{
+    uint32_t key[2] {};
+    uint64_t counter = 0;     // index of the next block to generate
+
+    double buffer[2] {};
+    int bufferPos = 2;        // next unused value in buffer; 2 means empty
+
+    static constexpr uint32_t M0 = 0xD2511F53;
+    static constexpr uint32_t M1 = 0xCD9E8D57;
+    static constexpr uint32_t W0 = 0x9E3779B9;
+    static constexpr uint32_t W1 = 0xBB67AE85;
+    static constexpr int Rounds = 10;
+
+    static double toUniform(uint32_t hi, uint32_t lo)
+    {
+        // Top 53 bits, offset by half a step so that neither 0 nor 1 can be returned
+        uint64_t bits = ((uint64_t(hi) << 32) | lo) >> 11;
+        return (double(bits) + 0.5) * 0x1.0p-53;
+    }
+
+    void generateBlock(uint64_t blockNum, double* out) const
+    {
+        uint32_t ctr[4];
+        block(blockNum, ctr);
+
+        out[0] = toUniform(ctr[0], ctr[1]);
+        out[1] = toUniform(ctr[2], ctr[3]);
+    }
+
+public:
+
+    void Seed(int scenNumber, RandomStream stream)
+    {
+        key[0] = uint32_t(scenNumber);
+        key[1] = uint32_t(stream);
+        Seek(0);
+    }
+
+    // Compatibility with the other generators: the seed is used as the key with stream 0
+    void Reseed(long nSeed)
+    {
+        key[0] = uint32_t(nSeed);
+        key[1] = 0;
+        Seek(0);
+    }
+
+    // Positions the stream so that the next value returned is draw number drawNum (counting from 0)
+    void Seek(uint64_t drawNum)
+    {
+        counter = drawNum / 2;
+        bufferPos = 2;
+
+        if (drawNum % 2 != 0)
+        {
+            generateBlock(counter++, buffer);
+            bufferPos = 1;
+        }
+    }
+
+    double GetNext()
+    {
+        if (bufferPos == 2)
+        {
+            generateBlock(counter++, buffer);
+            bufferPos = 0;
+        }
+
+        return buffer[bufferPos++];
+    }
+
+    // Same values as calling GetNext() out.size() times, but whole blocks go straight to the output
+    void Fill(std::span<double> out)
+    {
+        size_t i = 0;
+
+        while (i < out.size() && bufferPos != 2)
+            out[i++] = GetNext();
+
+        for (; i + 2 <= out.size(); i += 2)
+            generateBlock(counter++, &out[i]);
+
+        for (; i < out.size(); i++)
+            out[i] = GetNext();
+    }
+
+    // Standard normal shocks, numProcesses per month; for a pseudo-random generator the layout does not matter
+    void FillNormals(std::span<double> out, [[maybe_unused]] int numProcesses)
+    {
+        Fill(out);
+        InverseNormal(out, out);
+    }
+
+    // The raw Philox4x32-10 function: four 32-bit random words for the given block of the current key
+    void block(uint64_t blockNum, uint32_t ctr[4]) const
+    {
+        ctr[0] = uint32_t(blockNum);
+        ctr[1] = uint32_t(blockNum >> 32);
+        ctr[2] = 0;
+        ctr[3] = 0;
+
+        uint32_t k0 = key[0];
+        uint32_t k1 = key[1];
+
+        for (int round = 0; round < Rounds; round++)
+        {
+            uint64_t p0 = uint64_t(M0) * ctr[0];
+            uint64_t p1 = uint64_t(M1) * ctr[2];
+
+            uint32_t c0 = uint32_t(p1 >> 32) ^ ctr[1] ^ k0;
+            uint32_t c1 = uint32_t(p1);
+            uint32_t c2 = uint32_t(p0 >> 32) ^ ctr[3] ^ k1;
+            uint32_t c3 = uint32_t(p0);
+
+            ctr[0] = c0; ctr[1] = c1; ctr[2] = c2; ctr[3] = c3;
+
+            k0 += W0;
+            k1 += W1;
+        }
+    }
+};
+
+// Seeds rng for a scenario and fills out with its normal shocks.  With antithetic set the
+// scenarios come in mirrored pairs: scenarios 2k-1 and 2k both use the draws of pair k,
+// and the even scenario of the pair has every draw negated.
+template <typename Generator>
+void FillScenarioNormals(Generator& rng, int scenNumber, RandomStream stream, bool antithetic, std::span<double> out, int numProcesses)
+{
+    rng.Seed(antithetic ? (scenNumber + 1) / 2 : scenNumber, stream);
+    rng.FillNormals(out, numProcesses);
+
+    if (antithetic && scenNumber % 2 == 0)
+    {
+        for (auto& z : out)
+            z = -z;
+    }
+}
@@ -1,82 +1,132 @@
 #include "Cholesky.h"
 
 #include <cmath>
+#include <stdexcept>
+#include <string>
 
 
-double Cholesky::GetRandNum(long row, long col) const
+CholeskyFactor::CholeskyFactor(const actlib::table<double>& correlations)
 {
-    return mRandom(row, col);
-}
-
-
-void Cholesky::SetRandNum(long row, long col, double num)
-{
-    mRandom(row, col) = num;
-}
-
+    // Performs Cholesky factorization of the correlation matrix to get mA()
 
-double Cholesky::corrNum(long row, long col) const
-{
-    return mCorrelated(row, col);
-}
-
-void Cholesky::setup(long nVars, long nObs, actlib::table<double> correlations)
-{
-    // The argument correlations() must be  a correlation matrix with
-    // nVars rows and columns.
-
-    numVars = nVars;
-    numObs = nObs;
-    mRandom     = actlib::table<double>(numVars, numObs);
-    mCorrelated = actlib::table<double>(numVars, numObs);
-    mCorr       = actlib::table<double>(numVars, numVars);
-    mA          = actlib::table<double>(numVars, numVars);
+    constexpr double Tolerance = 1e-8;   // allowed rounding in the symmetry and the unit diagonal of the input
+    constexpr double MinPivot = 1e-12;   // smaller pivots mean the matrix is singular or not positive definite
 
-    mCorr = correlations;
+    if (correlations.size(1) != correlations.size(2))
+        throw std::invalid_argument("correlation matrix is not square");
 
-    calcConversionMatrix();
-}
+    numVars = correlations.size(1);
+    mA.assign(numVars * (numVars + 1) / 2, 0.);
 
-void Cholesky::calcConversionMatrix()
-{
-    // Performs Cholesky factorization of mCorr() to get mA()
+    for (int i = 0; i < numVars; i++)
+    {
+        if (std::abs(correlations(i, i) - 1) > Tolerance)
+            throw std::invalid_argument("correlation matrix diagonal entry " + std::to_string(i) + " is not 1");
 
-    mA(0, 0) = sqrt(mCorr(0, 0));
+        for (int j = 0; j < i; j++)
+        {
+            if (std::abs(correlations(i, j) - correlations(j, i)) > Tolerance)
+                throw std::invalid_argument("correlation matrix is not symmetric at (" + std::to_string(i) + ", " + std::to_string(j) + ")");
+        }
+    }
 
-    for (int i = 1; i < numVars; i++)
+    for (int i = 0; i < numVars; i++)
     {
-        for (int j = 1; j < i; j++)
+        for (int j = 0; j < i; j++)
         {
-            mA(i, j) = mCorr(i, j);
+            factor(i, j) = correlations(i, j);
 
             for (int k = 0; k < j; k++)
-                mA(i, j) = mA(i, j) - mA(i, k) * mA(j, k);
+                factor(i, j) = factor(i, j) - factor(i, k) * factor(j, k);
 
-            mA(i, j) = mA(i, j) / mA(j, j);
+            factor(i, j) = factor(i, j) / factor(j, j);
         }
 
-        mA(i, i) = mCorr(i, i);
+        double pivot = correlations(i, i);
 
         for (int k = 0; k < i; k++)
-            mA(i, i) = mA(i, i) - mA(i, k) * mA(i, k);
+            pivot = pivot - factor(i, k) * factor(i, k);
+
+        // Also catches a NaN pivot
+        if (!(pivot > MinPivot))
+            throw std::invalid_argument("correlation matrix is not positive definite: pivot " + std::to_string(i) + " is " + std::to_string(pivot) +
+                                        ". Fix the correlations or repair them with --repair_correlations");
+
+        factor(i, i) = sqrt(pivot);
+    }
+}
+
+
+void Cholesky::setup(const CholeskyFactor& factor, long nObs)
+{
+    mFactor = &factor;
 
-        mA(i, i) = sqrt(mA(i, i));
+    if (factor.size() != numVars || nObs != numObs)
+    {
+        numVars = factor.size();
+        numObs = nObs;
+        mCorrelated.assign(numVars * numObs, 0.);
+        mBlock.assign(numVars * ObsBlock, 0.);
     }
 }
 
-void Cholesky::correlate()
+void Cholesky::correlate(std::span<const double> uncorrelated)
 {
     // Multiplies the factored correlation matrix by the uncorrelated
     // random number array
 
-    for (int obs = 0; obs < numObs; obs++)
+    if (uncorrelated.size() != size_t(numVars * numObs))
+        throw std::invalid_argument("Cholesky::correlate: expected numVars * numObs random numbers");
+
+    const double* in = uncorrelated.data();
+    double* block = mBlock.data();
+
+    long obs = 0;
+
+    for (; obs + ObsBlock <= numObs; obs += ObsBlock)
     {
+        // Transpose the block so the ObsBlock values of each variable are adjacent
+        for (int b = 0; b < ObsBlock; b++)
+            for (int i = 0; i < numVars; i++)
+                block[i * ObsBlock + b] = in[(obs + b) * numVars + i];
+
+        const double* row = mFactor->data();
+
         for (int var = 0; var < numVars; var++)
         {
-            mCorrelated(var, obs) = 0.;
-            for (int i = 0; i < numVars; i++)
-                mCorrelated(var, obs) = mCorrelated(var, obs) + mA(var, i) * mRandom(i, obs);
+            double sum[ObsBlock] = {};
+
+            // Terms above the diagonal of mA are zero and are skipped
+            for (int i = 0; i <= var; i++)
+            {
+                for (int b = 0; b < ObsBlock; b++)
+                    sum[b] = sum[b] + row[i] * block[i * ObsBlock + b];
+            }
+
+            double* out = &mCorrelated[var * numObs + obs];
+
+            for (int b = 0; b < ObsBlock; b++)
+                out[b] = sum[b];
 
+            row += var + 1;
         }
     }
-}
\ No newline at end of file
+
+    // Observations left over after the last whole block
+    for (; obs < numObs; obs++)
+    {
+        const double* row = mFactor->data();
+
+        for (int var = 0; var < numVars; var++)
+        {
+            double sum = 0.;
+
+            for (int i = 0; i <= var; i++)
+                sum = sum + row[i] * in[obs * numVars + i];
+
+            mCorrelated[var * numObs + obs] = sum;
+
+            row += var + 1;
+        }
+    }
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <span>
+#include <vector>
+
 #include "Table.h"
 
 /**
@@ -16,32 +19,78 @@
  * correlated or uncorrelated.  The rows or C will be
  * correlated to the degree specified by mCorr.
  *
- * To use this object, first call setup() to initialize the
- * size of the matrices and specify correlations.  Then
- * generate uncorrelated random numbers to fill the matrix mRandom().
- * Finally, call correlate() to create the correlated matrix
- * named mCorrelated().  You can then use the values from
- * that matrix.
+ * The correlation matrix is fixed for a run, so it is factored once
+ * into a CholeskyFactor, which checks that the matrix is a valid
+ * correlation matrix.  The factor is read-only afterwards and is
+ * shared by every thread.
+ *
+ * To correlate random numbers, first call setup() on a Cholesky
+ * object with the factor and the number of observations.  Then call
+ * correlate() with the uncorrelated random numbers, stored
+ * observation by observation, to create the correlated numbers,
+ * which corrNum() returns.
+ *
+ * mA is lower triangular, so only its lower half is stored,
+ * packed row by row.  correlate() works on blocks of observations:
+ * it transposes a block of the input so each variable's values are
+ * adjacent, then accumulates every row of mA across the block, which
+ * the compiler turns into vector instructions across observations.
+ * The products are summed in the same order as a plain
+ * matrix-vector multiply.
  */
 
+class CholeskyFactor
+{
+    long numVars = 0;        // number of rows and columns in the correlation matrix
+    std::vector<double> mA;  // lower triangle packed by row: row i starts at i * (i + 1) / 2
+
+    double& factor(long row, long col)
+    {
+        return mA[row * (row + 1) / 2 + col];
+    }
+
+public:
+
+    // Throws std::invalid_argument if correlations is not a symmetric matrix with a unit
+    // diagonal, or is not positive definite (see NearestCorrelationMatrix() for a repair)
+    explicit CholeskyFactor(const actlib::table<double>& correlations);
+
+    long size() const
+    {
+        return numVars;
+    }
+
+    // The packed lower triangle
+    const double* data() const
+    {
+        return mA.data();
+    }
+};
+
+
 class Cholesky
 {
-    long numVars;                 //number of rows and columns in the correlation matrix
-    long numObs;                  // number of observations to correlate
+    const CholeskyFactor* mFactor = nullptr;
+    long numVars = 0;             // number of rows and columns in the correlation matrix
+    long numObs = 0;              // number of observations to correlate
 
-    actlib::table<double> mCorr;       // The correlation matrix (input)
-    actlib::table<double> mA;          // The Choleski factoriztion of the correlation matrix
-    actlib::table<double> mRandom;     // The input uncorrelated random matrix U
-    actlib::table<double> mCorrelated; // The output correlated random matrix C
+    static constexpr int ObsBlock = 8;  // observations correlated together
 
-    void calcConversionMatrix();
+    actlib::aligned_vector<double> mCorrelated;   // The output correlated random numbers, numObs per variable
+    actlib::aligned_vector<double> mBlock;        // One block of the input, ObsBlock values per variable
 
 public:
 
-    double GetRandNum(long row, long col) const;
-    double corrNum(long row, long col) const;
+    double corrNum(long row, long col) const
+    {
+        return mCorrelated[row * numObs + col];
+    }
+
+    // The buffers are kept when setup() is called again with the same sizes,
+    // so correlating one scenario after another does not reallocate them.
+    // The factor must outlive the calls to correlate().
+    void setup(const CholeskyFactor& factor, long nObs);
 
-    void SetRandNum(long row, long col, double num);
-    void setup(long nVars, long nObs, actlib::table<double> correlations);
-    void correlate();
-};
\ No newline at end of file
+    // uncorrelated holds numVars values for each of the numObs observations
+    void correlate(std::span<const double> uncorrelated);
+};
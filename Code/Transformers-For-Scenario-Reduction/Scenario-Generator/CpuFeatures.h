@@ -0,0 +1,61 @@
+#pragma once
+
+/**
+ * Run-time detection of the vector instructions used by the batch kernels.
+ *
+ * A kernel written with AVX2 intrinsics is compiled into the normal build and only
+ * called when cpuHasAvx2() is true, so the program still runs on CPUs without AVX2.
+ * SIMD_AVX2 is defined on x64, where such kernels can be compiled at all.
+ */
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define SIMD_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC accepts AVX2 intrinsics in any function; GCC and Clang need the function marked.
+// INLINE_AVX2 is for small helpers of the kernels, which must be inlined to keep their constants in registers.
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define INLINE_AVX2 inline __attribute__((target("avx2"), always_inline))
+#else
+#define TARGET_AVX2
+#define INLINE_AVX2 __forceinline
+#endif
+
+
+#ifdef SIMD_AVX2
+
+inline bool cpuHasAvx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    // The OS must save the AVX registers on a context switch as well as the CPU supporting AVX2
+    __cpuid(info, 1);
+    bool osSavesAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+
+    __cpuidex(info, 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0;
+
+    return osSavesAvx && avx2;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#else
+
+inline bool cpuHasAvx2()
+{
+    return false;
+}
+
+#endif
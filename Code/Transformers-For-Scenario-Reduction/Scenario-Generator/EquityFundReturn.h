@@ -24,6 +24,8 @@ class EquityFundReturn
     double SETmedianReturn {};
     double SETvolatility {};
 
+    friend class FundScenarioBatch;
+
 public:
 
     double currentVol {};
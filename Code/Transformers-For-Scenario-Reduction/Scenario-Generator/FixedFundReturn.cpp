@@ -2,10 +2,10 @@
 
 #include <cmath>
 
-double FixedFundReturn::getNextReturn(YieldCurve prevYldCurve, YieldCurve currYldCurve, double shock)
+double FixedFundReturn::getNextReturn(YieldCurveView prevYldCurve, YieldCurveView currYldCurve, double shock) const
 {
-    double prevIntRate = prevYldCurve.rateAtMaturity(maturity);
-    double currIntRate = currYldCurve.rateAtMaturity(maturity);
+    double prevIntRate = prevYldCurve.rateAt(maturityPoint);
+    double currIntRate = currYldCurve.rateAt(maturityPoint);
 
     double currReturn = monthlyFactor * (prevIntRate + monthlySpread) + duration * (prevIntRate - currIntRate) + shock * sqrt(prevIntRate) * volatility;
 
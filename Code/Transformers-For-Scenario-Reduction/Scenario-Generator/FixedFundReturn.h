@@ -17,8 +17,12 @@ class FixedFundReturn
     double duration      {};  // measured in years
     double volatility    {};  // volatility due to credit spreads
 
+    YieldCurveView::MaturityPoint maturityPoint {};  // where maturity falls on every yield curve
+
+    friend class FundScenarioBatch;
+
 public:
-    double getNextReturn(YieldCurve prevYldCurve, YieldCurve currYldCurve, double shock);
+    double getNextReturn(YieldCurveView prevYldCurve, YieldCurveView currYldCurve, double shock) const;
 
     FixedFundReturn() = default;
 
@@ -27,7 +31,8 @@ public:
         monthlyFactor(params.monthlyFactor),
         monthlySpread(params.monthlySpread),
         duration(params.duration),
-        volatility(params.volatility)
+        volatility(params.volatility),
+        maturityPoint(YieldCurveView::maturityPoint(params.maturity))
     {}
 
 };
@@ -1,8 +1,12 @@
 #include "FundScenario.h"
 
+#include "InverseNormal.h"
 #include "StochasticExclusionTest.h"
 #include "ScenarioGenerator.h"
 
+#include <stdexcept>
+
+
 double FundScenario::wealthFactor(int monthNum, int n) const
 {
     return returns(n, monthNum);
@@ -15,6 +19,15 @@ double FundScenario::totalReturn(int monthNum, int n) const
 }
 
 
+void FundScenario::totalReturns(int n, double* out) const
+{
+    std::span<const double> wealth = wealthFactors(n);
+
+    for (size_t month = 1; month < wealth.size(); month++)
+        out[month - 1] = wealth[month] / wealth[month - 1] - 1;
+}
+
+
 double FundScenario::randNum(int monthNum, int n)
 {
     // This should only be called after Generate() has been executed.
@@ -23,50 +36,68 @@ double FundScenario::randNum(int monthNum, int n)
 }
 
 
-template <typename Generator>
-void FundScenario::Generate(int scenNumber, IntScenario intScenario, bool testScenario, int ProjectionYears, 
-                            actlib::table<double> CorrelationMatrix, Generator& m_RNG, EquityFundReturn DiversifiedFund,
-                            EquityFundReturn InternationalFund, EquityFundReturn IntermediateRiskFund, EquityFundReturn AggressiveFund,
-                            FixedFundReturn MoneyFund, FixedFundReturn IntGovtFund, FixedFundReturn LongCorpFund)
+void FundScenario::startPath(int ProjectionYears, const CholeskyFactor& correlationFactor)
 {
     numMonths = ProjectionYears * 12;  // Number of yield curves generate
 
     // Set up the array of returns to generate and initialize first value to 1.0
-    returns = actlib::table<double>(9, numMonths + 1);
+    // The array is only reallocated when the projection length changes
+    if (returns.size(1) != 9 || returns.size(2) != numMonths + 1)
+        returns = actlib::table<double>(9, numMonths + 1);
 
     for (auto j = 0; j <= 8; j++)
         returns(j, 0) = 1;
 
-    // Set up the random number correlator
-    correlator.setup(11, numMonths, CorrelationMatrix);
+    // randNum() reads 11 correlated shocks a month without checking the index, so the factor must be that size
+    if (correlationFactor.size() != 11)
+        throw std::invalid_argument("FundScenario: the fund correlation matrix must be 11 by 11");
 
+    // Set up the random number correlator with the factor of the correlation matrix computed for the run
+    correlator.setup(correlationFactor, numMonths);
+}
 
+
+template <typename Generator>
+void FundScenario::drawShocks(int scenNumber, bool antithetic, Generator& m_RNG)
+{
     // Generate the uncorrelated random numbers
     // Re-seed the generator based on scenario number
-    m_RNG.Reseed(scenNumber - 1 + 10200);
+    normalDraws.resize(11 * numMonths);
 
-    for (auto i = 0; i < numMonths; i++)
-    {
-        for (auto j = 0; j <= 10; j++)
-            correlator.SetRandNum(j, i, InverseNormal(m_RNG.GetNext()));
-    }
+    FillScenarioNormals(m_RNG, scenNumber, RandomStream::FundReturns, antithetic, normalDraws, 11);
 
     // Use Cholesky decomposition to correlate the random samples
-    correlator.correlate();
+    correlator.correlate(normalDraws);
+}
+
+
+template <typename Generator>
+void FundScenario::Generate(int scenNumber, const IntScenario& intScenario, const TestShockTable* testShocks, bool antithetic, int ProjectionYears, 
+                            const CholeskyFactor& correlationFactor, Generator& m_RNG, EquityFundReturn& DiversifiedFund,
+                            EquityFundReturn& InternationalFund, EquityFundReturn& IntermediateRiskFund, EquityFundReturn& AggressiveFund,
+                            const FixedFundReturn& MoneyFund, const FixedFundReturn& IntGovtFund, const FixedFundReturn& LongCorpFund)
+{
+    startPath(ProjectionYears, correlationFactor);
 
     // Loop by month generating new rates
-    if (testScenario)
+    if (testShocks)
     {
+        if (testShocks->getNumMonths() < numMonths)
+            throw std::invalid_argument("the stochastic exclusion test shocks are shorter than the projection");
+
+        // The test scenarios take no random draws
+        std::span<const double> equityShocks = testShocks->path(scenNumber, EquityShock);
+
         for (auto i = 1; i <= numMonths; i++)
         {
-            returns(0, i) = DiversifiedFund.getNextReturnSET(testShock(scenNumber, i, EquityShock));
-            returns(1, i) = InternationalFund.getNextReturnSET(testShock(scenNumber, i, EquityShock));
-            returns(2, i) = IntermediateRiskFund.getNextReturnSET(testShock(scenNumber, i, EquityShock));
-            returns(3, i) = AggressiveFund.getNextReturnSET(testShock(scenNumber, i, EquityShock));
+            returns(0, i) = DiversifiedFund.getNextReturnSET(equityShocks[i - 1]);
+            returns(1, i) = InternationalFund.getNextReturnSET(equityShocks[i - 1]);
+            returns(2, i) = IntermediateRiskFund.getNextReturnSET(equityShocks[i - 1]);
+            returns(3, i) = AggressiveFund.getNextReturnSET(equityShocks[i - 1]);
 
             // The prior and current yield curves are needed here
-            YieldCurve priorCurve = intScenario.curve(i - 1);
-            YieldCurve currentCurve = intScenario.curve(i);
+            YieldCurveView priorCurve = intScenario.curve(i - 1);
+            YieldCurveView currentCurve = intScenario.curve(i);
 
             returns(4, i) = MoneyFund.getNextReturn(priorCurve, currentCurve, 0);
             returns(5, i) = IntGovtFund.getNextReturn(priorCurve, currentCurve, 0);
@@ -75,14 +106,18 @@ void FundScenario::Generate(int scenNumber, IntScenario intScenario, bool testSc
             returns(7, i) = 0.65 * returns(5, i) + 0.35 * returns(6, i);  // Blended FIXED fund
             returns(8, i) = 0.6 * returns(0, i) + 0.4 * returns(7, i);    // Blended BALANCED fund
 
-            for (auto j = 0; j <= 8; j++)  // convert each return into a cumulative wealth factor
-            {
-                returns(j, i) = returns(j, i - 1) * (1 + returns(j, i));
-            }
+            // Convert each return into a cumulative wealth factor; month i of every fund, one column apart
+            auto prior = returns.row_view(i - 1);
+            auto current = returns.row_view(i);
+
+            for (auto j = 0; j <= 8; j++)
+                current[j] = prior[j] * (1 + current[j]);
         }
     }
     else
     {
+        drawShocks(scenNumber, antithetic, m_RNG);
+
         for (auto i = 1; i <= numMonths; i++)
         {
             int k = i - 1; // used to index into random number array
@@ -92,8 +127,8 @@ void FundScenario::Generate(int scenNumber, IntScenario intScenario, bool testSc
             returns(3, i) = AggressiveFund.getNextReturn(randNum(k, 7), randNum(k, 6));
 
             // The prior and current yield curves are needed here
-            YieldCurve priorCurve = intScenario.curve(i - 1);
-            YieldCurve currentCurve = intScenario.curve(i);
+            YieldCurveView priorCurve = intScenario.curve(i - 1);
+            YieldCurveView currentCurve = intScenario.curve(i);
 
             returns(4, i) = MoneyFund.getNextReturn(priorCurve, currentCurve, randNum(k, 8));
             returns(5, i) = IntGovtFund.getNextReturn(priorCurve, currentCurve, randNum(k, 9));
@@ -102,48 +137,45 @@ void FundScenario::Generate(int scenNumber, IntScenario intScenario, bool testSc
             returns(7, i) = 0.65 * returns(5, i) + 0.35 * returns(6, i);  // Blended FIXED fund
             returns(8, i) = 0.6 * returns(0, i) + 0.4 * returns(7, i);    // Blended BALANCED fund
 
-            for (auto j = 0; j <= 8; j++)  // convert each return into a cumulative wealth factor
-                returns(j, i) = returns(j, i - 1) * (1 + returns(j, i));
+            // Convert each return into a cumulative wealth factor; month i of every fund, one column apart
+            auto prior = returns.row_view(i - 1);
+            auto current = returns.row_view(i);
+
+            for (auto j = 0; j <= 8; j++)
+                current[j] = prior[j] * (1 + current[j]);
         }
     }
 }
 
 
-string FundScenario::serializeToJson() const
+void FundScenario::serializeToJson(JsonBuffer& out) const
 {
-    auto fundToString = [&](FundType f) -> string
-    {
-        string s;
-
-        s += "\"" + FundTypeToString(FundType(f)) + "\"";
+    // Reserve for the longest possible output so the buffer grows at most once
+    out.reserve(out.size() + NumOutputFunds * (numMonths * (JsonBuffer::MaxDoubleChars + 1) + 32) + 2);
 
-        s += ":";
+    out.put('{');
 
-        s += "[";
-
-        for (int month = returns.lower_bound(2) + 1; month < returns.upper_bound(2); month++)
-            s += std::to_string(totalReturn(month, f)) + ",";
-
-        s += std::to_string(totalReturn(returns.upper_bound(2), f));
+    for (int fund = FundType::First; fund <= FundType::Last; fund++)
+    {
+        out.put('"');
+        out.put(FundTypeToString(FundType(fund)));
+        out.put("\":[");
 
-        s += "]";
+        std::span<const double> wealth = wealthFactors(fund);
 
-        return s;
-    };
+        for (size_t month = 1; month < wealth.size() - 1; month++)
+        {
+            out.putNumber(wealth[month] / wealth[month - 1] - 1);
+            out.put(',');
+        }
 
-    string json;
+        out.putNumber(wealth[wealth.size() - 1] / wealth[wealth.size() - 2] - 1);
 
-    json += "{";
+        out.put(']');
 
-    for (int fund = FundType::First; fund < FundType::Last; fund++)
-    {
-        json += fundToString(FundType(fund));
-        json += ",\n";
+        if (fund != FundType::Last)
+            out.put(",\n");
     }
 
-    json += fundToString(FundType(FundType::Last));
-
-    json += "}";
-
-    return json;
+    out.put('}');
 }
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "Vector.h"
 #include "Cholesky.h"
@@ -8,6 +11,8 @@
 #include "C3RNG.h"
 #include "EquityFundReturn.h"
 #include "FixedFundReturn.h"
+#include "JsonBuffer.h"
+#include "SobolGenerator.h"
 
 using std::string;
 
@@ -30,7 +35,7 @@ class FundScenario
         Last = LongCorp
     };
 
-    constexpr static string FundTypeToString(FundType f)
+    constexpr static std::string_view FundTypeToString(FundType f)
     {
         switch (f)
         {
@@ -47,24 +52,74 @@ class FundScenario
     }
 
     Cholesky correlator;
+    actlib::aligned_vector<double> normalDraws;  // normal shocks for the whole scenario, 11 per month; kept between scenarios
+
+    // Sizes the returns for the projection, starts every wealth factor at 1, and sets up the correlator
+    void startPath(int ProjectionYears, const CholeskyFactor& correlationFactor);
+
+    // Draws the scenario's shocks and correlates them; correlator.corrNum() returns them afterwards
+    template <typename Generator>
+    void drawShocks(int scenNumber, bool antithetic, Generator& m_RNG);
+
+    // FundScenarioBatch writes the returns of several scenarios directly
+    friend class FundScenarioBatch;
 
 public:
 
+    // Number of funds written to the scenario output files (USDiversified through LongCorp)
+    static constexpr int NumOutputFunds = Last - First + 1;
+
+    static string fundName(int n)
+    {
+        return string(FundTypeToString(FundType(n)));
+    }
+
+    int getNumMonths() const
+    {
+        return numMonths;
+    }
+
     double wealthFactor(int monthNum, int n) const;
     double totalReturn(int monthNum, int n) const;
 
+    // Wealth factors of fund n for months 0 to getNumMonths(), straight out of the returns table
+    std::span<const double> wealthFactors(int n) const
+    {
+        return returns.col_span(n);
+    }
+
+    // The total returns of fund n for months 1 to getNumMonths(), written to out[0] onwards
+    void totalReturns(int n, double* out) const;
+
     double randNum(int monthNum, int n);
 
+    // The equity funds carry their volatility from one month to the next, so the caller resets it before each scenario.
+    // With antithetic set, each even scenario uses the negated draws of the odd scenario before it.
+    // With testShocks set, scenario scenNumber of the stochastic exclusion test is generated instead.
     template <typename Generator>
-    void Generate(int scenNumber, IntScenario intScenario, bool testScenario, int ProjectionYears,
-                  actlib::table<double> CorrelationMatrix, Generator& m_RNG, EquityFundReturn DiversifiedFund,
-                  EquityFundReturn InternationalFund, EquityFundReturn IntermediateRiskFund, EquityFundReturn AggressiveFund,
-                  FixedFundReturn MoneyFund, FixedFundReturn IntGovtFund, FixedFundReturn LongCorpFund);
+    void Generate(int scenNumber, const IntScenario& intScenario, const TestShockTable* testShocks, bool antithetic, int ProjectionYears,
+                  const CholeskyFactor& correlationFactor, Generator& m_RNG, EquityFundReturn& DiversifiedFund,
+                  EquityFundReturn& InternationalFund, EquityFundReturn& IntermediateRiskFund, EquityFundReturn& AggressiveFund,
+                  const FixedFundReturn& MoneyFund, const FixedFundReturn& IntGovtFund, const FixedFundReturn& LongCorpFund);
 
-    _NODISCARD string serializeToJson() const;
+    void serializeToJson(JsonBuffer& out) const;
 };
 
-template void FundScenario::Generate<MersenneTwister>(int scenNumber, IntScenario intScenario, bool testScenario, int ProjectionYears,
-    actlib::table<double> CorrelationMatrix, MersenneTwister& m_RNG, EquityFundReturn DiversifiedFund,
-    EquityFundReturn InternationalFund, EquityFundReturn IntermediateRiskFund, EquityFundReturn AggressiveFund,
-    FixedFundReturn MoneyFund, FixedFundReturn IntGovtFund, FixedFundReturn LongCorpFund);
+template void FundScenario::Generate<MersenneTwister>(int scenNumber, const IntScenario& intScenario, const TestShockTable* testShocks, bool antithetic, int ProjectionYears,
+    const CholeskyFactor& correlationFactor, MersenneTwister& m_RNG, EquityFundReturn& DiversifiedFund,
+    EquityFundReturn& InternationalFund, EquityFundReturn& IntermediateRiskFund, EquityFundReturn& AggressiveFund,
+    const FixedFundReturn& MoneyFund, const FixedFundReturn& IntGovtFund, const FixedFundReturn& LongCorpFund);
+
+template void FundScenario::Generate<Philox>(int scenNumber, const IntScenario& intScenario, const TestShockTable* testShocks, bool antithetic, int ProjectionYears,
+    const CholeskyFactor& correlationFactor, Philox& m_RNG, EquityFundReturn& DiversifiedFund,
+    EquityFundReturn& InternationalFund, EquityFundReturn& IntermediateRiskFund, EquityFundReturn& AggressiveFund,
+    const FixedFundReturn& MoneyFund, const FixedFundReturn& IntGovtFund, const FixedFundReturn& LongCorpFund);
+
+template void FundScenario::Generate<SobolGenerator>(int scenNumber, const IntScenario& intScenario, const TestShockTable* testShocks, bool antithetic, int ProjectionYears,
+    const CholeskyFactor& correlationFactor, SobolGenerator& m_RNG, EquityFundReturn& DiversifiedFund,
+    EquityFundReturn& InternationalFund, EquityFundReturn& IntermediateRiskFund, EquityFundReturn& AggressiveFund,
+    const FixedFundReturn& MoneyFund, const FixedFundReturn& IntGovtFund, const FixedFundReturn& LongCorpFund);
+
+template void FundScenario::drawShocks<MersenneTwister>(int scenNumber, bool antithetic, MersenneTwister& m_RNG);
+template void FundScenario::drawShocks<Philox>(int scenNumber, bool antithetic, Philox& m_RNG);
+template void FundScenario::drawShocks<SobolGenerator>(int scenNumber, bool antithetic, SobolGenerator& m_RNG);
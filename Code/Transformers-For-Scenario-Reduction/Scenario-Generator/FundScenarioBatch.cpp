@@ -0,0 +1,331 @@
+#include "FundScenarioBatch.h"
+
+#include <cmath>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+#include "BatchMath.h"
+
+
+namespace
+{
+    using namespace batch_math;
+
+    constexpr int Lanes = FundScenarioBatch::Lanes;
+
+    constexpr int NumEquityFunds = 4;
+    constexpr int NumBondFunds = 3;
+    constexpr int NumFunds = 9;     // the equity and bond funds, then the blended FIXED and BALANCED funds
+    constexpr int NumShocks = 11;   // a volatility and a return shock per equity fund, a shock per bond fund
+
+    constexpr double OneTwelfth = 1. / 12;
+    const double InvSqrt12 = 1 / std::sqrt(12.);
+
+
+    // EquityFundReturn::getNextReturn() with its logs worked out once
+    struct EquityTerms
+    {
+        double volDecay;         // 1 - meanRevStrength
+        double volPull;          // meanRevStrength * log(targetVol)
+        double maxLogVolBefore;
+        double volStdDev;
+        double minLogVol, maxLogVolAfter;
+        double a, b, C;
+        double startLogVol;
+
+        // EquityFundReturn::getNextReturnSET() is setReturn + shock * setShockScale
+        double setReturn, setShockScale;
+    };
+
+
+    struct BondTerms
+    {
+        double monthlyFactor, monthlySpread, duration, volatility;
+    };
+
+
+    struct FundTerms
+    {
+        EquityTerms equity[NumEquityFunds];
+        BondTerms bond[NumBondFunds];
+        bool testScenarios;  // stochastic exclusion test: each equity return shock is the test shock
+    };
+
+
+    // Where a lane writes its wealth factors: month m of fund j goes to wealth[j][m]
+    struct LaneReturns
+    {
+        double* wealth[NumFunds];
+    };
+
+
+    // The monthly loop of FundScenario::Generate() for one lane at a time
+    void advanceScalar(const FundTerms& ft, const double* shocks, const double* bondRates, int numMonths, const LaneReturns* lanes, int count)
+    {
+        for (int l = 0; l < count; l++)
+        {
+            double logVol[NumEquityFunds];
+            double wealth[NumFunds];
+
+            for (int f = 0; f < NumEquityFunds; f++)
+                logVol[f] = ft.equity[f].startLogVol;
+
+            for (int j = 0; j < NumFunds; j++)
+                wealth[j] = 1;
+
+            for (int m = 0; m < numMonths; m++)
+            {
+                const double* z = shocks + NumShocks * m * Lanes + l;
+                const double* prevRate = bondRates + NumBondFunds * m * Lanes + l;
+                const double* currRate = prevRate + NumBondFunds * Lanes;
+
+                double r[NumFunds];
+
+                for (int f = 0; f < NumEquityFunds; f++)
+                {
+                    const EquityTerms& e = ft.equity[f];
+
+                    if (ft.testScenarios)
+                    {
+                        r[f] = e.setReturn + z[(2 * f + 1) * Lanes] * e.setShockScale;
+                        continue;
+                    }
+
+                    // Mean reversion, the cap before the shock, then the cap and floor after it
+                    double x = minScalar(e.volDecay * logVol[f] + e.volPull, e.maxLogVolBefore);
+                    x = x + z[(2 * f) * Lanes] * e.volStdDev;
+                    x = maxScalar(minScalar(x, e.maxLogVolAfter), e.minLogVol);
+
+                    logVol[f] = x;
+
+                    double vol = expScalar(x);
+                    double meanReturn = e.a + e.b * vol + e.C * vol * vol;
+
+                    r[f] = expScalar(meanReturn * OneTwelfth + z[(2 * f + 1) * Lanes] * (vol * InvSqrt12)) - 1;
+                }
+
+                for (int f = 0; f < NumBondFunds; f++)
+                {
+                    const BondTerms& b = ft.bond[f];
+
+                    double prev = prevRate[f * Lanes];
+                    double curr = currRate[f * Lanes];
+
+                    r[NumEquityFunds + f] = b.monthlyFactor * (prev + b.monthlySpread) + b.duration * (prev - curr) + z[(2 * NumEquityFunds + f) * Lanes] * std::sqrt(prev) * b.volatility;
+                }
+
+                r[7] = 0.65 * r[5] + 0.35 * r[6];  // Blended FIXED fund
+                r[8] = 0.6 * r[0] + 0.4 * r[7];    // Blended BALANCED fund
+
+                for (int j = 0; j < NumFunds; j++)
+                {
+                    wealth[j] = wealth[j] * (1 + r[j]);
+                    lanes[l].wealth[j][m + 1] = wealth[j];
+                }
+            }
+        }
+    }
+
+
+#ifdef SIMD_AVX2
+
+    // advanceScalar() with the four lanes in one register
+    TARGET_AVX2 void advanceAvx2(const FundTerms& ft, const double* shocks, const double* bondRates, int numMonths, const LaneReturns* lanes, int count)
+    {
+        const __m256d one = _mm256_set1_pd(1);
+        const __m256d oneTwelfth = _mm256_set1_pd(OneTwelfth);
+        const __m256d invSqrt12 = _mm256_set1_pd(InvSqrt12);
+
+        __m256d logVol[NumEquityFunds];
+        __m256d wealth[NumFunds];
+
+        for (int f = 0; f < NumEquityFunds; f++)
+            logVol[f] = _mm256_set1_pd(ft.equity[f].startLogVol);
+
+        for (int j = 0; j < NumFunds; j++)
+            wealth[j] = one;
+
+        // One month of wealth factors, by fund then lane, copied out to each lane's returns
+        alignas(32) double out[NumFunds][Lanes];
+
+        for (int m = 0; m < numMonths; m++)
+        {
+            const double* z = shocks + NumShocks * m * Lanes;
+            const double* prevRate = bondRates + NumBondFunds * m * Lanes;
+            const double* currRate = prevRate + NumBondFunds * Lanes;
+
+            __m256d r[NumFunds];
+
+            for (int f = 0; f < NumEquityFunds; f++)
+            {
+                const EquityTerms& e = ft.equity[f];
+
+                if (ft.testScenarios)
+                {
+                    r[f] = _mm256_add_pd(_mm256_set1_pd(e.setReturn), _mm256_mul_pd(_mm256_loadu_pd(z + (2 * f + 1) * Lanes), _mm256_set1_pd(e.setShockScale)));
+                    continue;
+                }
+
+                __m256d x = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(e.volDecay), logVol[f]), _mm256_set1_pd(e.volPull));
+                x = _mm256_min_pd(x, _mm256_set1_pd(e.maxLogVolBefore));
+                x = _mm256_add_pd(x, _mm256_mul_pd(_mm256_loadu_pd(z + (2 * f) * Lanes), _mm256_set1_pd(e.volStdDev)));
+                x = _mm256_max_pd(_mm256_min_pd(x, _mm256_set1_pd(e.maxLogVolAfter)), _mm256_set1_pd(e.minLogVol));
+
+                logVol[f] = x;
+
+                __m256d vol = expAvx2(x);
+                __m256d meanReturn = _mm256_add_pd(_mm256_add_pd(_mm256_set1_pd(e.a), _mm256_mul_pd(_mm256_set1_pd(e.b), vol)),
+                                                   _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(e.C), vol), vol));
+
+                __m256d logReturn = _mm256_add_pd(_mm256_mul_pd(meanReturn, oneTwelfth),
+                                                  _mm256_mul_pd(_mm256_loadu_pd(z + (2 * f + 1) * Lanes), _mm256_mul_pd(vol, invSqrt12)));
+
+                r[f] = _mm256_sub_pd(expAvx2(logReturn), one);
+            }
+
+            for (int f = 0; f < NumBondFunds; f++)
+            {
+                const BondTerms& b = ft.bond[f];
+
+                __m256d prev = _mm256_loadu_pd(prevRate + f * Lanes);
+                __m256d curr = _mm256_loadu_pd(currRate + f * Lanes);
+
+                __m256d carry = _mm256_mul_pd(_mm256_set1_pd(b.monthlyFactor), _mm256_add_pd(prev, _mm256_set1_pd(b.monthlySpread)));
+                __m256d priceChange = _mm256_mul_pd(_mm256_set1_pd(b.duration), _mm256_sub_pd(prev, curr));
+                __m256d credit = _mm256_mul_pd(_mm256_mul_pd(_mm256_loadu_pd(z + (2 * NumEquityFunds + f) * Lanes), _mm256_sqrt_pd(prev)), _mm256_set1_pd(b.volatility));
+
+                r[NumEquityFunds + f] = _mm256_add_pd(_mm256_add_pd(carry, priceChange), credit);
+            }
+
+            r[7] = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(0.65), r[5]), _mm256_mul_pd(_mm256_set1_pd(0.35), r[6]));
+            r[8] = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(0.6), r[0]), _mm256_mul_pd(_mm256_set1_pd(0.4), r[7]));
+
+            for (int j = 0; j < NumFunds; j++)
+            {
+                wealth[j] = _mm256_mul_pd(wealth[j], _mm256_add_pd(one, r[j]));
+                _mm256_store_pd(out[j], wealth[j]);
+            }
+
+            for (int l = 0; l < count; l++)
+                for (int j = 0; j < NumFunds; j++)
+                    lanes[l].wealth[j][m + 1] = out[j][l];
+        }
+    }
+
+#endif
+
+
+    using FundKernel = void (*)(const FundTerms&, const double*, const double*, int, const LaneReturns*, int);
+
+    FundKernel selectFundKernel()
+    {
+#ifdef SIMD_AVX2
+        if (cpuHasAvx2())
+            return advanceAvx2;
+#endif
+        return advanceScalar;
+    }
+}
+
+
+template <typename Generator>
+void FundScenarioBatch::Generate(int firstScenario, int count, const TestShockTable* testShocks, bool antithetic, const IntScenarioBatch& rates, int ProjectionYears,
+                                 const CholeskyFactor& correlationFactor, Generator& m_RNG, const EquityFundReturn& DiversifiedFund,
+                                 const EquityFundReturn& InternationalFund, const EquityFundReturn& IntermediateRiskFund, const EquityFundReturn& AggressiveFund,
+                                 const FixedFundReturn& MoneyFund, const FixedFundReturn& IntGovtFund, const FixedFundReturn& LongCorpFund)
+{
+    static const FundKernel kernel = selectFundKernel();
+
+    if (count < 1 || count > Lanes)
+        throw std::invalid_argument("FundScenarioBatch: a batch holds 1 to " + std::to_string(Lanes) + " scenarios");
+
+    if (correlationFactor.size() != NumShocks)
+        throw std::invalid_argument("FundScenarioBatch: the fund correlation matrix must be " + std::to_string(NumShocks) + " by " + std::to_string(NumShocks));
+
+    const FixedFundReturn* bondFunds[NumBondFunds] = { &MoneyFund, &IntGovtFund, &LongCorpFund };
+
+    int numMonths = ProjectionYears * 12;
+
+    if (testShocks && testShocks->getNumMonths() < numMonths)
+        throw std::invalid_argument("the stochastic exclusion test shocks are shorter than the projection");
+
+    // Each scenario draws and correlates its own shocks, which are interleaved by lane.
+    // The bond funds' rates are read off each lane's curves.  Unused lanes are left at zero.
+    shocks.assign(NumShocks * numMonths * Lanes, 0.);
+    bondRates.assign(NumBondFunds * (numMonths + 1) * Lanes, 0.);
+
+    for (int l = 0; l < count; l++)
+    {
+        FundScenario& scn = scenarios[l];
+
+        scn.startPath(ProjectionYears, correlationFactor);
+
+        if (testShocks)
+        {
+            // Every equity fund takes the scenario's equity shock; the other shocks stay zero
+            std::span<const double> equityShocks = testShocks->path(firstScenario + l, EquityShock);
+
+            for (int f = 0; f < NumEquityFunds; f++)
+                for (int m = 0; m < numMonths; m++)
+                    shocks[(NumShocks * m + 2 * f + 1) * Lanes + l] = equityShocks[m];
+        }
+        else
+        {
+            scn.drawShocks(firstScenario + l, antithetic, m_RNG);
+
+            for (int n = 0; n < NumShocks; n++)
+                for (int m = 0; m < numMonths; m++)
+                    shocks[(NumShocks * m + n) * Lanes + l] = scn.correlator.corrNum(n, m);
+        }
+
+        const IntScenario& intScenario = rates.scenario(l);
+
+        for (int m = 0; m <= numMonths; m++)
+        {
+            YieldCurveView curve = intScenario.curve(m);
+
+            for (int f = 0; f < NumBondFunds; f++)
+                bondRates[(NumBondFunds * m + f) * Lanes + l] = curve.rateAt(bondFunds[f]->maturityPoint);
+        }
+    }
+
+    FundTerms ft;
+
+    ft.testScenarios = testShocks != nullptr;
+
+    const EquityFundReturn* equityFunds[NumEquityFunds] = { &DiversifiedFund, &InternationalFund, &IntermediateRiskFund, &AggressiveFund };
+
+    for (int f = 0; f < NumEquityFunds; f++)
+    {
+        const EquityFundReturn& e = *equityFunds[f];
+
+        ft.equity[f] = EquityTerms{
+            .volDecay = 1 - e.meanRevStrength,
+            .volPull = e.meanRevStrength * log(e.targetVol),
+            .maxLogVolBefore = log(e.maxVolBefore),
+            .volStdDev = e.volStdDev,
+            .minLogVol = log(e.minVol),
+            .maxLogVolAfter = log(e.maxVolAfter),
+            .a = e.a, .b = e.b, .C = e.C,
+            .startLogVol = log(e.currentVol),
+            .setReturn = pow(1. + e.SETmedianReturn, 1. / 12) - 1,
+            .setShockScale = e.SETvolatility / sqrt(12.)
+        };
+    }
+
+    for (int f = 0; f < NumBondFunds; f++)
+    {
+        const FixedFundReturn& b = *bondFunds[f];
+
+        ft.bond[f] = BondTerms{ b.monthlyFactor, b.monthlySpread, b.duration, b.volatility };
+    }
+
+    LaneReturns lanes[Lanes];
+
+    for (int l = 0; l < count; l++)
+        for (int j = 0; j < NumFunds; j++)
+            lanes[l].wealth[j] = &scenarios[l].returns(j, 0);
+
+    kernel(ft, shocks.data(), bondRates.data(), numMonths, lanes, count);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "C3RNG.h"
+#include "Cholesky.h"
+#include "EquityFundReturn.h"
+#include "FixedFundReturn.h"
+#include "FundScenario.h"
+#include "IntScenarioBatch.h"
+#include "SobolGenerator.h"
+
+/**
+ * Generates the fund returns of the scenarios in an IntScenarioBatch, one scenario per lane.
+ *
+ * FundScenario::Generate() steps seven fund objects through a month at a time for one scenario.
+ * Here the state of each fund (the log volatility of the equity funds, the wealth factor of every
+ * fund) is kept across the lanes, and all seven funds are advanced for every lane together with
+ * AVX2.  The shocks are drawn and correlated one scenario at a time, as FundScenario does, and
+ * interleaved by lane for the kernel.
+ *
+ * The equity volatility is kept as a log, with its cap and floors applied to the log, so the three
+ * logs of EquityFundReturn::getNextReturn() go and two exponentials are left.  The bond funds read
+ * their rates through each fund's precomputed maturity point.  The returns agree with
+ * FundScenario::Generate() to about 1e-14 rather than exactly.  In stochastic exclusion test
+ * scenarios the equity funds take EquityFundReturn::getNextReturnSET() instead, with the shocks
+ * read from a TestShockTable, and give the same equity returns as FundScenario::Generate().
+ */
+
+class FundScenarioBatch
+{
+public:
+
+    static constexpr int Lanes = IntScenarioBatch::Lanes;
+
+private:
+
+    std::array<FundScenario, Lanes> scenarios;
+
+    actlib::aligned_vector<double> shocks;     // correlated shock n of month m for lane l at (11 * m + n) * Lanes + l
+    actlib::aligned_vector<double> bondRates;  // rate of bond fund f at month m for lane l at (3 * m + f) * Lanes + l
+
+public:
+
+    // Generates scenarios firstScenario to firstScenario + count - 1 from the interest rate paths in
+    // lanes 0 to count - 1 of rates.  The equity funds start from their currentVol, which is not changed.
+    // With testShocks set they are stochastic exclusion test scenarios, as rates must be too.
+    template <typename Generator>
+    void Generate(int firstScenario, int count, const TestShockTable* testShocks, bool antithetic, const IntScenarioBatch& rates, int ProjectionYears,
+                  const CholeskyFactor& correlationFactor, Generator& m_RNG, const EquityFundReturn& DiversifiedFund,
+                  const EquityFundReturn& InternationalFund, const EquityFundReturn& IntermediateRiskFund, const EquityFundReturn& AggressiveFund,
+                  const FixedFundReturn& MoneyFund, const FixedFundReturn& IntGovtFund, const FixedFundReturn& LongCorpFund);
+
+    const FundScenario& scenario(int lane) const
+    {
+        return scenarios[lane];
+    }
+};
+
+template void FundScenarioBatch::Generate<MersenneTwister>(int firstScenario, int count, const TestShockTable* testShocks, bool antithetic, const IntScenarioBatch& rates, int ProjectionYears,
+    const CholeskyFactor& correlationFactor, MersenneTwister& m_RNG, const EquityFundReturn& DiversifiedFund,
+    const EquityFundReturn& InternationalFund, const EquityFundReturn& IntermediateRiskFund, const EquityFundReturn& AggressiveFund,
+    const FixedFundReturn& MoneyFund, const FixedFundReturn& IntGovtFund, const FixedFundReturn& LongCorpFund);
+
+template void FundScenarioBatch::Generate<Philox>(int firstScenario, int count, const TestShockTable* testShocks, bool antithetic, const IntScenarioBatch& rates, int ProjectionYears,
+    const CholeskyFactor& correlationFactor, Philox& m_RNG, const EquityFundReturn& DiversifiedFund,
+    const EquityFundReturn& InternationalFund, const EquityFundReturn& IntermediateRiskFund, const EquityFundReturn& AggressiveFund,
+    const FixedFundReturn& MoneyFund, const FixedFundReturn& IntGovtFund, const FixedFundReturn& LongCorpFund);
+
+template void FundScenarioBatch::Generate<SobolGenerator>(int firstScenario, int count, const TestShockTable* testShocks, bool antithetic, const IntScenarioBatch& rates, int ProjectionYears,
+    const CholeskyFactor& correlationFactor, SobolGenerator& m_RNG, const EquityFundReturn& DiversifiedFund,
+    const EquityFundReturn& InternationalFund, const EquityFundReturn& IntermediateRiskFund, const EquityFundReturn& AggressiveFund,
+    const FixedFundReturn& MoneyFund, const FixedFundReturn& IntGovtFund, const FixedFundReturn& LongCorpFund);
@@ -1,135 +1,519 @@
 #include "HistCurves.h"
 
+#include <algorithm>
+#include <cfloat>
+#include <charconv>
 #include <cmath>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
-#include <iterator>
-#include <sstream>
+#include <stdexcept>
+#include <string_view>
 #include <vector>
 
 using std::ifstream;
+using std::ofstream;
 using std::vector;
 
-vector<string> split(string s, const string& delim)
+namespace
 {
-    vector<string> v;
+    // Columns of the historical curves used for fitting: the 1, 7 and 20 year rates
+    constexpr int ShortRateColumn = 3;
+    constexpr int MidRateColumn = 7;
+    constexpr int LongRateColumn = 9;
 
-    int idx_start = 0;
-    while (idx_start < s.length())
+    // Weights given to the short, mid, and long rate in the fitting criteria
+    constexpr double WEIGHT_SHORT = 40;
+    constexpr double WEIGHT_MID = 20;
+    constexpr double WEIGHT_LONG = 40;
+
+    // Fit method 1 is sum of absolute differences, method 2 is sum of squares.
+    // The index bounds use this too, so the operations must stay monotone in each difference.
+    template <int FitMethod>
+    double curveFit(double d_Diff_S, double d_Diff_M, double d_Diff_L)
     {
-        int idx_end = s.find(delim, idx_start);
+        if constexpr (FitMethod == 1) // method 1 is sum of absolute value of differences
+        {
+            d_Diff_S = std::abs(d_Diff_S);
+            d_Diff_M = std::abs(d_Diff_M);
+            d_Diff_L = std::abs(d_Diff_L);
+        }
+        else    // method 2 is sum of squared differences
+        {
+            d_Diff_S = d_Diff_S * d_Diff_S;
+            d_Diff_M = d_Diff_M * d_Diff_M;
+            d_Diff_L = d_Diff_L * d_Diff_L;
+        }
 
-        idx_end = idx_end == string::npos ? s.length() : idx_end;
+        return WEIGHT_SHORT * d_Diff_S + WEIGHT_MID * d_Diff_M + WEIGHT_LONG * d_Diff_L;
+    }
 
-        v.emplace_back(s.substr(idx_start, idx_end - idx_start));
-        
-        idx_start = idx_end + 1;
+    constexpr double FitWeights[] = { WEIGHT_SHORT, WEIGHT_MID, WEIGHT_LONG };
+
+    // Maturities of the curve points in years, and the names of the per-maturity files
+    constexpr double MaturityYears[] = { 0.25, 0.5, 1, 2, 3, 5, 7, 10, 20, 30 };
+    constexpr const char* MaturityFileNames[] = { "0.25.csv", "0.5.csv", "1.csv", "2.csv", "3.csv", "5.csv", "7.csv", "10.csv", "20.csv", "30.csv" };
+
+    bool isBinaryFile(const string& filename)
+    {
+        return std::filesystem::path(filename).extension() == ".bin";
     }
-    return v;
+
+    string readFile(const string& filename)
+    {
+        ifstream file(filename, std::ios::binary | std::ios::ate);
+
+        if (!file)
+            throw std::runtime_error("unable to open historical curve file " + filename);
+
+        string text(size_t(file.tellg()), '\0');
+
+        file.seekg(0);
+        file.read(text.data(), text.size());
+
+        return text;
+    }
+
+    bool isSeparator(char c)
+    {
+        return c == ',' || c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    // Parses the number at next and moves next past it
+    template <typename T>
+    T parseNumber(const char*& next, const char* end, const string& filename)
+    {
+        T value;
+        auto [ptr, ec] = std::from_chars(next, end, value);
+
+        if (ec != std::errc())
+            throw std::runtime_error("invalid number in historical curve file " + filename + " at \"" + string(next, std::min(end, next + 20)) + "\"");
+
+        next = ptr;
+
+        return value;
+    }
+
+    // Reads a file of rates separated by commas or white space into rates
+    void parseRateList(const string& filename, vector<double>& rates)
+    {
+        string text = readFile(filename);
+
+        const char* next = text.data();
+        const char* end = next + text.size();
+
+        rates.clear();
+
+        while (true)
+        {
+            while (next != end && isSeparator(*next))
+                next++;
+
+            if (next == end)
+                break;
+
+            rates.push_back(parseNumber<double>(next, end, filename));
+        }
+    }
+}
+
+
+HistCurves::HistCurves()
+{
+    for (int i = 1; i <= numCurvePoints; i++)
+        maturities(i) = MaturityYears[i - 1];
 }
 
-void load_historical_data(map<Date, map<double, double>>& out, Date start_date, double maturity, string file_path)
+
+void HistCurves::allocate(Date first, int curveCount)
 {
-    ifstream infile(file_path);
+    if (curveCount <= 0)
+        throw std::runtime_error("the historical curve data is empty");
 
-    string csv_str;
-    std::getline(infile, csv_str);
+    firstDate = first;
+    numCurves = curveCount;
 
-    auto historical_rates = split(csv_str, ",");
+    curves = actlib::table<double>(X_Range{ .lo = 1, .hi = numCurves }, Y_Range{ .lo = 1, .hi = numCurvePoints });
+}
 
-    Date curr_date = start_date;
 
-    for (const auto& val : historical_rates)
+void HistCurves::buildIndex()
+{
+    vector<double> shortRates(numCurves), midRates(numCurves), longRates(numCurves);
+
+    for (int i = 1; i <= numCurves; i++)
     {
-        out[curr_date][maturity] = std::stod(val);
-        curr_date = next_month(curr_date);
+        shortRates[i - 1] = curves(i, ShortRateColumn);
+        midRates[i - 1] = curves(i, MidRateColumn);
+        longRates[i - 1] = curves(i, LongRateColumn);
     }
+
+    index.build(shortRates, midRates, longRates);
 }
 
-void HistCurves::Initialize(map<Date, map<double, double>> historicalData)
+
+void HistCurves::LoadMaturityFiles(const string& directory, Date first)
 {
-    maturities(1) = 0.25;
-    maturities(2) = 0.5;
-    maturities(3) = 1;
-    maturities(4) = 2;
-    maturities(5) = 3;
-    maturities(6) = 5;
-    maturities(7) = 7;
-    maturities(8) = 10;
-    maturities(9) = 20;
-    maturities(10) = 30;
+    vector<double> rates;
 
-    auto earliestCurve = historicalData.begin();
-    numCurves = static_cast<int>(historicalData.size());
+    for (int m = 1; m <= numCurvePoints; m++)
+    {
+        string filename = (std::filesystem::path(directory) / MaturityFileNames[m - 1]).string();
 
-    curves = actlib::table<double>(X_Range{ .lo = 1, .hi = numCurves }, Y_Range{ .lo = 1, .hi = numCurvePoints });
+        parseRateList(filename, rates);
+
+        if (m == 1)
+            allocate(first, int(rates.size()));
+        else if (int(rates.size()) != numCurves)
+            throw std::runtime_error("historical curve file " + filename + " has " + std::to_string(rates.size()) + " rates but " +
+                                     MaturityFileNames[0] + " has " + std::to_string(numCurves));
 
-    firstDate = historicalData.begin()->first;
+        for (int i = 1; i <= numCurves; i++)
+            curves(i, m) = rates[i - 1];
+    }
+
+    buildIndex();
+}
 
-    int curveNum = 1;
-    for (const auto& [date, curve] : historicalData)
+
+void HistCurves::Load(const string& filename)
+{
+    if (isBinaryFile(filename))
+        loadBinary(filename);
+    else
+        loadCsv(filename);
+
+    buildIndex();
+}
+
+
+void HistCurves::loadCsv(const string& filename)
+{
+    string text = readFile(filename);
+
+    // The header line names the maturities; the other non-empty lines are the curves
+    vector<std::string_view> lines;
+
+    for (size_t pos = 0; pos < text.size();)
     {
-        int maturityNum = 1;
-        for (const auto& [maturity, rate] : curve)
+        size_t eol = std::min(text.find('\n', pos), text.size());
+        std::string_view line(text.data() + pos, eol - pos);
+
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+
+        if (!line.empty())
+            lines.push_back(line);
+
+        pos = eol + 1;
+    }
+
+    if (lines.size() < 2)
+        throw std::runtime_error("historical curve file " + filename + " has no curves");
+
+    Date date {};
+
+    for (int i = 1; i < int(lines.size()); i++)
+    {
+        const char* next = lines[i].data();
+        const char* end = next + lines[i].size();
+
+        int year = parseNumber<int>(next, end, filename);
+
+        if (next == end || *next++ != '-')
+            throw std::runtime_error("historical curve file " + filename + " has a date that is not yyyy-mm on line " + std::to_string(i + 1));
+
+        int month = parseNumber<int>(next, end, filename);
+
+        if (i == 1)
+        {
+            if (month < JANUARY || month > DECEMBER)
+                throw std::runtime_error("historical curve file " + filename + " has an invalid month on line 2");
+
+            date = Date{ .month = Month(month), .year = short(year) };
+            allocate(date, int(lines.size()) - 1);
+        }
+        else
         {
-            curves(curveNum, maturityNum) = rate;
-            maturityNum++;
+            date = next_month(date);
+
+            if (year != date.year || month != date.month)
+                throw std::runtime_error("historical curve file " + filename + " skips a month on line " + std::to_string(i + 1));
+        }
+
+        for (int m = 1; m <= numCurvePoints; m++)
+        {
+            if (next == end || *next++ != ',')
+                throw std::runtime_error("historical curve file " + filename + " has fewer than " + std::to_string(numCurvePoints) + " rates on line " + std::to_string(i + 1));
+
+            curves(i, m) = parseNumber<double>(next, end, filename);
         }
-        curveNum++;
+
+        if (next != end)
+            throw std::runtime_error("historical curve file " + filename + " has more than " + std::to_string(numCurvePoints) + " rates on line " + std::to_string(i + 1));
     }
 }
 
 
-int HistCurves::BestFittingCurve(double d_shortRate, double d_midRate, double d_longRate, int l_fitMethod)
+void HistCurves::loadBinary(const string& filename)
 {
-    // Fit method 1 is sum of absolute differences, method 2 is sum of squares.
+    ifstream file(filename, std::ios::binary);
 
-    int l_Best_YC = -1;
-    double d_Diff_YC;
+    if (!file)
+        throw std::runtime_error("unable to open historical curve file " + filename);
 
-    // Weights given to the short, mid, and long rate in the fitting criteria
-    constexpr double WEIGHT_SHORT = 40;
-    constexpr double WEIGHT_MID = 20;
-    constexpr double WEIGHT_LONG = 40;
+    HistCurveFileHeader header {};
+    double fileMaturities[numCurvePoints];
 
-    double d_MinDiff = DBL_MAX;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (!file || std::memcmp(header.magic, HIST_CURVE_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != HIST_CURVE_FILE_VERSION)
+        throw std::runtime_error(filename + " is not a historical curve file");
+
+    if (header.numMaturities != numCurvePoints || header.firstMonth < JANUARY || header.firstMonth > DECEMBER)
+        throw std::runtime_error("historical curve file " + filename + " has an unsupported layout");
+
+    file.read(reinterpret_cast<char*>(fileMaturities), sizeof(fileMaturities));
+
+    if (!file || !std::equal(fileMaturities, fileMaturities + numCurvePoints, MaturityYears))
+        throw std::runtime_error("historical curve file " + filename + " has different maturities");
+
+    allocate(Date{ .month = Month(header.firstMonth), .year = short(header.firstYear) }, int(header.numCurves));
+
+    // The rates of one curve are adjacent in the table and the curves follow one another, as in the file
+    file.read(reinterpret_cast<char*>(&curves(1, 1)), std::streamsize(numCurves) * numCurvePoints * sizeof(double));
+
+    if (!file)
+        throw std::runtime_error("historical curve file " + filename + " is truncated");
+}
+
+
+void HistCurves::Save(const string& filename) const
+{
+    ofstream file(filename, std::ios::binary | std::ios::trunc);
+
+    if (!file)
+        throw std::runtime_error("unable to create historical curve file " + filename);
 
-    // Iterate through all the historical yield curves
-    for (int l_YC_Counter = 1; l_YC_Counter <= numCurves; l_YC_Counter++)
+    if (isBinaryFile(filename))
     {
-        double d_histShortRate = curves(l_YC_Counter, 3);
-        double d_histMidRate = curves(l_YC_Counter, 7);
-        double d_histLongRate = curves(l_YC_Counter, 9);
+        HistCurveFileHeader header {};
+
+        std::memcpy(header.magic, HIST_CURVE_FILE_MAGIC, sizeof(header.magic));
+        header.version       = HIST_CURVE_FILE_VERSION;
+        header.firstYear     = uint32_t(firstDate.year);
+        header.firstMonth    = uint32_t(firstDate.month);
+        header.numCurves     = uint32_t(numCurves);
+        header.numMaturities = numCurvePoints;
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(MaturityYears), sizeof(MaturityYears));
+        file.write(reinterpret_cast<const char*>(curves.col_data(1)), std::streamsize(numCurves) * numCurvePoints * sizeof(double));
+    }
+    else
+    {
+        // to_chars writes the shortest text that reads back as the same double
+        char buffer[32];
+        string text = "date";
+
+        for (double maturity : MaturityYears)
+            text.append(",").append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), maturity).ptr);
 
-        double d_Diff_S = d_shortRate - d_histShortRate;
-        double d_Diff_M = d_midRate - d_histMidRate;
-        double d_Diff_L = d_longRate - d_histLongRate;
+        text.append("\n");
 
-        if (l_fitMethod == 1) // method 1 is sum of absolute value of differences
+        Date date = firstDate;
+
+        for (int i = 1; i <= numCurves; i++, date = next_month(date))
         {
-            d_Diff_S = abs(d_Diff_S);
-            d_Diff_M = abs(d_Diff_M);
-            d_Diff_L = abs(d_Diff_L);
+            text.append(std::to_string(date.year)).append(date.month < 10 ? "-0" : "-").append(std::to_string(date.month));
+
+            for (int m = 1; m <= numCurvePoints; m++)
+                text.append(",").append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), curves(i, m)).ptr);
+
+            text.append("\n");
         }
-        else    // method 2 is sum of squared differences
+
+        file.write(text.data(), text.size());
+    }
+
+    if (!file)
+        throw std::runtime_error("error writing historical curve file " + filename);
+}
+
+
+void HistCurveIndex::build(const vector<double>& shortRates, const vector<double>& midRates, const vector<double>& longRates)
+{
+    points.resize(shortRates.size());
+
+    for (size_t i = 0; i < points.size(); i++)
+        points[i] = Point{ { shortRates[i], midRates[i], longRates[i] }, int(i) + 1 };
+
+    nodes.clear();
+
+    if (!points.empty())
+        buildNode(0, int(points.size()));
+}
+
+
+int HistCurveIndex::buildNode(int begin, int end)
+{
+    int nodeNum = int(nodes.size());
+    nodes.emplace_back();
+
+    Node node;
+    node.begin = begin;
+    node.end = end;
+
+    for (int d = 0; d < Dims; d++)
+    {
+        node.lo[d] = DBL_MAX;
+        node.hi[d] = -DBL_MAX;
+    }
+
+    for (int i = begin; i < end; i++)
+    {
+        for (int d = 0; d < Dims; d++)
         {
-            d_Diff_S = d_Diff_S * d_Diff_S;
-            d_Diff_M = d_Diff_M * d_Diff_M;
-            d_Diff_L = d_Diff_L * d_Diff_L;
+            node.lo[d] = std::min(node.lo[d], points[i].rate[d]);
+            node.hi[d] = std::max(node.hi[d], points[i].rate[d]);
         }
+    }
 
-        d_Diff_YC = WEIGHT_SHORT * d_Diff_S + WEIGHT_MID * d_Diff_M + WEIGHT_LONG * d_Diff_L;
+    if (end - begin > LeafSize)
+    {
+        // Split at the median of the dimension with the largest weighted spread
+        int splitDim = 0;
 
-        // Replace the minimum if a smaller difference is found
-        if (d_Diff_YC < d_MinDiff)
+        for (int d = 1; d < Dims; d++)
         {
-            d_MinDiff = d_Diff_YC;
-            l_Best_YC = l_YC_Counter;
+            if (FitWeights[d] * (node.hi[d] - node.lo[d]) > FitWeights[splitDim] * (node.hi[splitDim] - node.lo[splitDim]))
+                splitDim = d;
         }
 
+        int mid = begin + (end - begin) / 2;
+
+        std::nth_element(points.begin() + begin, points.begin() + mid, points.begin() + end,
+                         [splitDim](const Point& a, const Point& b) { return a.rate[splitDim] < b.rate[splitDim]; });
+
+        node.left = buildNode(begin, mid);
+        node.right = buildNode(mid, end);
     }
 
-    return l_Best_YC;
+    nodes[nodeNum] = node;
+
+    return nodeNum;
+}
+
+
+template <int FitMethod>
+void HistCurveIndex::search(int nodeNum, const double query[Dims], double& bestFit, int& bestCurve) const
+{
+    const Node& node = nodes[nodeNum];
+
+    if (node.left < 0)
+    {
+        for (int i = node.begin; i < node.end; i++)
+        {
+            const Point& p = points[i];
+
+            double fit = curveFit<FitMethod>(query[0] - p.rate[0], query[1] - p.rate[1], query[2] - p.rate[2]);
+
+            // The scan keeps the first of equally good curves, so ties go to the lower curve number
+            if (fit < bestFit || (fit == bestFit && p.curve < bestCurve))
+            {
+                bestFit = fit;
+                bestCurve = p.curve;
+            }
+        }
+
+        return;
+    }
+
+    // Lower bound on the fit of any curve in a node: the differences to the nearest edge of its box
+    auto bound = [&](const Node& child) {
+        double diff[Dims];
 
+        for (int d = 0; d < Dims; d++)
+            diff[d] = query[d] < child.lo[d] ? query[d] - child.lo[d] : query[d] > child.hi[d] ? query[d] - child.hi[d] : 0;
+
+        return curveFit<FitMethod>(diff[0], diff[1], diff[2]);
+    };
+
+    int first = node.left;
+    int second = node.right;
+
+    double firstBound = bound(nodes[first]);
+    double secondBound = bound(nodes[second]);
+
+    if (secondBound < firstBound)
+    {
+        std::swap(first, second);
+        std::swap(firstBound, secondBound);
+    }
+
+    // A node whose bound equals the best fit may still hold a tie with a lower curve number
+    if (firstBound <= bestFit)
+        search<FitMethod>(first, query, bestFit, bestCurve);
+
+    if (secondBound <= bestFit)
+        search<FitMethod>(second, query, bestFit, bestCurve);
+}
+
+
+int HistCurveIndex::nearest(double shortRate, double midRate, double longRate, int fitMethod) const
+{
+    double bestFit = DBL_MAX;
+    int bestCurve = -1;
+
+    if (nodes.empty())
+        return bestCurve;
+
+    const double query[Dims] = { shortRate, midRate, longRate };
+
+    if (fitMethod == 1)
+        search<1>(0, query, bestFit, bestCurve);
+    else
+        search<2>(0, query, bestFit, bestCurve);
+
+    return bestCurve;
+}
+
+
+int HistCurves::BestFittingCurve(double d_shortRate, double d_midRate, double d_longRate, int l_fitMethod) const
+{
+    return index.nearest(d_shortRate, d_midRate, d_longRate, l_fitMethod);
+}
+
+
+int HistCurves::BestFittingCurveScan(double d_shortRate, double d_midRate, double d_longRate, int l_fitMethod) const
+{
+    int l_Best_YC = -1;
+    double d_MinDiff = DBL_MAX;
+
+    auto scan = [&](auto fit) {
+        // Iterate through all the historical yield curves
+        for (int l_YC_Counter = 1; l_YC_Counter <= numCurves; l_YC_Counter++)
+        {
+            double d_Diff_YC = fit(d_shortRate - curves(l_YC_Counter, ShortRateColumn),
+                                   d_midRate - curves(l_YC_Counter, MidRateColumn),
+                                   d_longRate - curves(l_YC_Counter, LongRateColumn));
+
+            // Replace the minimum if a smaller difference is found
+            if (d_Diff_YC < d_MinDiff)
+            {
+                d_MinDiff = d_Diff_YC;
+                l_Best_YC = l_YC_Counter;
+            }
+        }
+    };
+
+    // The fit method is chosen once rather than for every curve
+    if (l_fitMethod == 1)
+        scan(curveFit<1>);
+    else
+        scan(curveFit<2>);
+
+    return l_Best_YC;
 }
 
 
@@ -150,12 +534,8 @@ map<double, double> HistCurves::getCurveByDate(Date date) const
 {
     map<double, double> result;
 
-    for (auto m = maturities.cbegin(); m != maturities.cend(); m++)
-    {
-        int idx = std::distance(maturities.cbegin(), m);
-
-        result[*m] = histCurveRateByDate(date, idx);
-    }
+    for (int i = maturities.lower_bound(); i <= maturities.upper_bound(); i++)
+        result[maturities(i)] = histCurveRateByDate(date, i);
 
     return result;
 }
@@ -168,7 +548,7 @@ actlib::vector<double> HistCurves::getCurveVecByDate(Date date) const
 
     for (auto m = maturities.cbegin(); m != maturities.cend(); m++)
     {
-        int idx = std::distance(m, maturities.cbegin()) + 1; // the underlying data structure is 1-indexed, not 0-indexed
+        int idx = std::distance(maturities.cbegin(), m) + 1; // the underlying data structure is 1-indexed, not 0-indexed
 
         *(result_itr++) = histCurveRateByDate(date, idx);
     }
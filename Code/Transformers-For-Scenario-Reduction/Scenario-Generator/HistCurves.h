@@ -4,13 +4,85 @@
 #include "Table.h"
 #include "Vector.h"
 
+#include <cstdint>
 #include <map>
 #include <string>
+#include <vector>
 
 using std::map;
 using std::string;
 
-void load_historical_data (map<Date, map<double, double>> &out, Date start_date, double maturity, string file_path);
+
+/**
+ * Layout of a consolidated historical curve file in binary form (see HistCurves::Save()).
+ *
+ * The header is followed by the numMaturities maturities in years, then by the curves one
+ * month after another starting at firstYear/firstMonth, each curve being numMaturities rates.
+ * Values are in the native byte order of the machine that wrote the file.
+ */
+
+constexpr char     HIST_CURVE_FILE_MAGIC[4] = { 'H', 'C', 'R', 'V' };
+constexpr uint32_t HIST_CURVE_FILE_VERSION  = 1;
+
+struct HistCurveFileHeader
+{
+    char     magic[4];
+    uint32_t version;
+    uint32_t firstYear;
+    uint32_t firstMonth;
+    uint32_t numCurves;
+    uint32_t numMaturities;
+};
+
+
+/**
+ * A k-d tree over the (1 year, 7 year, 20 year) rates of the historical curves, used to find
+ * the curve that best fits a generated curve without scanning every curve.
+ *
+ * Each node keeps the bounding box of its curves.  A search visits the child on the query's
+ * side first and skips a node when even the nearest point of its box fits worse than the best
+ * curve found so far.  The box bound is computed with the same floating point operations as the
+ * fit of a curve on the box edge, so it never exceeds the fit of any curve inside, and ties are
+ * broken by the lower curve number.  The result is therefore exactly the curve the linear scan
+ * in HistCurves::BestFittingCurveScan() returns.
+ */
+
+class HistCurveIndex
+{
+    static constexpr int Dims = 3;      // short, mid and long rate
+    static constexpr int LeafSize = 8;  // curves in a node before it is split
+
+    struct Point
+    {
+        double rate[Dims];
+        int curve;
+    };
+
+    struct Node
+    {
+        double lo[Dims];
+        double hi[Dims];
+        int begin, end;         // range of points in the node
+        int left = -1;          // children, or -1 for a leaf
+        int right = -1;
+    };
+
+    std::vector<Point> points;
+    std::vector<Node> nodes;
+
+    int buildNode(int begin, int end);
+
+    template <int FitMethod>
+    void search(int node, const double query[Dims], double& bestFit, int& bestCurve) const;
+
+public:
+
+    // shortRates[i], midRates[i] and longRates[i] are the rates of curve i + 1
+    void build(const std::vector<double>& shortRates, const std::vector<double>& midRates, const std::vector<double>& longRates);
+
+    // Fit method 1 is sum of absolute differences, any other is sum of squares
+    int nearest(double shortRate, double midRate, double longRate, int fitMethod) const;
+};
 
 
 class HistCurves
@@ -23,14 +95,44 @@ class HistCurves
     actlib::vector<double> maturities = actlib::vector<double>(Range{ .lo = 1, .hi = numCurvePoints });
     actlib::table<double> curves;
 
+    HistCurveIndex index;  // built after loading over the rates used for fitting
+
+    void allocate(Date first, int curveCount);
+    void buildIndex();
+
+    void loadCsv(const string& filename);
+    void loadBinary(const string& filename);
+
     double histCurveRateByDate(Date date, int maturityIndex) const;
 
 public:
 
-    void Initialize(map<Date, map<double, double>> historicalData);
-    int BestFittingCurve(double d_shortRate, double d_midRate, double d_longRate, int l_fitMethod);
+    HistCurves();
+
+    // Reads the ten files 0.25.csv, 0.5.csv, ... 30.csv in directory.  Each holds one line of comma
+    // separated monthly rates for its maturity, the first of which is for firstDate.
+    void LoadMaturityFiles(const string& directory, Date firstDate);
+
+    // Reads a consolidated file written by Save(): binary if the name ends in .bin, otherwise CSV
+    // with a header line followed by one line per month of the form yyyy-mm,rate,rate,...
+    void Load(const string& filename);
+
+    // Writes every curve to one file, in binary if the name ends in .bin and otherwise as CSV
+    void Save(const string& filename) const;
+
+    // The historical curve whose 1, 7 and 20 year rates best fit the given rates.  Uses the index.
+    int BestFittingCurve(double d_shortRate, double d_midRate, double d_longRate, int l_fitMethod) const;
+
+    // The same search as a scan of every curve; the benchmarks check the index against it
+    int BestFittingCurveScan(double d_shortRate, double d_midRate, double d_longRate, int l_fitMethod) const;
+
     double histCurveRateByIndex(int curveIndex, int maturityIndex) const;
 
+    int getNumCurves() const
+    {
+        return numCurves;
+    }
+
     Date getFirstDate() const
     {
         return firstDate;
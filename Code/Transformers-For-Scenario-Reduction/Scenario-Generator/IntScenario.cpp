@@ -1,17 +1,31 @@
 #include "IntScenario.h"
 
 #include "C3RNG.h"
+#include "InverseNormal.h"
 #include "StochasticExclusionTest.h"
 #include "ScenarioGenerator.h"
 
 #include <cmath>
+#include <span>
+#include <stdexcept>
 
 
 double Minr2;
 
-YieldCurve& IntScenario::curve(int curveNum)
+YieldCurveView IntScenario::curve(int curveNum) const
 {
-    return curves(curveNum);
+    return YieldCurveView(rates.col_data(curveNum));
+}
+
+
+void IntScenario::saveCurve(int curveNum, const YieldCurve& yldCurve)
+{
+    for (auto j = 1; j <= YieldCurve::NumMaturities; j++)
+        rates(curveNum, j) = yldCurve.rateAtIndex(j);
+
+    shortRates(curveNum) = yldCurve.generatedRate(1);
+    longRates(curveNum)  = yldCurve.generatedRate(2);
+    logVols(curveNum)    = yldCurve.getLogVolatility();
 }
 
 
@@ -33,8 +47,7 @@ double IntScenario::significance()
     
     for (auto i = 1; i <= n; i++)
     {
-        YieldCurve& yldCurve = curves(i);
-        double intRate = yldCurve.rateAtMaturity(20);
+        double intRate = curve(i).rateAtMaturity(20);
 
         v = pow(v * (1 + intRate / 2), -0.33333333333);
         s = s + v;
@@ -46,64 +59,81 @@ double IntScenario::significance()
 }
 
 
-/**
- *
- * This routine generates an interest rate scenario.
- * Arguments:
- * scenNumber     determines the random number seed for stochastic scenarios
- * testScenario   determines whether to generate one of the stochastic
- *                exclusion test scenarios.
- */
-template <typename Generator>
-void IntScenario::Generate(int scenNumber, bool testScenario, actlib::vector<double> initialRateCurve, int ProjectionYears, ScenarioGeneratorParams params, Generator& m_RNG)
+void IntScenario::startPath(const actlib::vector<double>& initialRateCurve, int ProjectionYears, const ScenarioGeneratorParams& params)
 {
-    // Items used in the interpolation of yield curves for the Stochastic Exclusion Test
-    actlib::vector<double> initialCurveFit(Range{ .lo = 1, .hi = 10 });        // Variances between NS fitted curve and actual initial curve, by duration
-
     numCurves = ProjectionYears * 12;  // Number of yield curves generate
 
-    // Set up the arrays to generate
-    actlib::table<double> randNums (numCurves, 3);
-    curves = actlib::vector<YieldCurve>(numCurves + 1);
+    // Set up the arrays to generate.  They are only reallocated when the projection length changes;
+    // every element used is overwritten, and Initialize() fully resets the working curve.
+    if (rates.size(1) != numCurves + 1)
+    {
+        rates      = actlib::table<double>(X_Range{ .lo = 0, .hi = numCurves }, Y_Range{ .lo = 1, .hi = YieldCurve::NumMaturities });
+        shortRates = actlib::vector<double>(numCurves + 1);
+        longRates  = actlib::vector<double>(numCurves + 1);
+        logVols    = actlib::vector<double>(numCurves + 1);
+    }
 
     // Initialize the starting yield curve
-    curves(0) = YieldCurve();
-
-    curves(0).Initialize(params.int_params.initial_short_rate, params.int_params.initial_long_rate, log(params.int_params.initial_volatility));
+    workCurve.Initialize(params.int_params.initial_short_rate, params.int_params.initial_long_rate, log(params.int_params.initial_volatility));
 
     if (true)  // If (testScenario) Then
     {
-        curves(0).interpolateNS();
-
+        // Initialize() has already interpolated the curve, so the fit is to the curve in the selected interpolation method
         for (auto i = 1; i <= 10; i++)
-            initialCurveFit(i) = initialRateCurve(i) - curves(0).rateAtIndex(i);
+            initialCurveFit(i) = initialRateCurve(i) - workCurve.rateAtIndex(i);
 
-         curves(0).perturb(initialCurveFit, 1);
+         workCurve.perturb(initialCurveFit, 1);
     }
 
+    saveCurve(0, workCurve);
+}
 
 
+/**
+ *
+ * This routine generates an interest rate scenario.
+ * Arguments:
+ * scenNumber     determines the random number seed for stochastic scenarios
+ * testShocks     the stochastic exclusion test shocks when generating test
+ *                scenario scenNumber instead of a stochastic one, otherwise null.
+ */
+template <typename Generator>
+void IntScenario::Generate(int scenNumber, const TestShockTable* testShocks, bool antithetic, const actlib::vector<double>& initialRateCurve, int ProjectionYears, const ScenarioGeneratorParams& params, Generator& m_RNG)
+{
+    startPath(initialRateCurve, ProjectionYears, params);
+
+    if (randNums.size(1) != numCurves || randNums.size(2) != 3)
+        randNums = actlib::table<double>(numCurves, 3);
+
     // Generate the random numbers*****************************
-    if (testScenario)
+    if (testShocks)
     {
-        for (auto i = 1; i <= numCurves; i++)
-        {
-            randNums(i, 1) = testShock(scenNumber, i, LongIntShock);
-            randNums(i, 2) = testShock(scenNumber, i, IntDiffShock);
-            randNums(i, 3) = 0;
+        if (testShocks->getNumMonths() < numCurves)
+            throw std::invalid_argument("the stochastic exclusion test shocks are shorter than the projection");
 
-            randNums(i, 2) = randNums(i, 1) * params.correl12 + randNums(i, 2) * params.const1;
+        std::span<const double> longShocks = testShocks->path(scenNumber, LongIntShock);
+        std::span<const double> diffShocks = testShocks->path(scenNumber, IntDiffShock);
+
+        // Row i holds the shocks for month i + 1, as in the stochastic branch; there is no volatility shock
+        for (auto i = 0; i < numCurves; i++)
+        {
+            randNums(i, 0) = longShocks[i];
+            randNums(i, 1) = randNums(i, 0) * params.correl12 + diffShocks[i] * params.const1;
+            randNums(i, 2) = 0;
         }
     }
     else
     {
-        m_RNG.Reseed(scenNumber - 1 + 200); // Re-seed the generator based on scenario number
+        // First generate the uncorrelated random numbers, drawing the uniforms in month order
+        // and converting them to normals in one batch.  The generator is re-seeded based on scenario number.
+        normalDraws.resize(3 * numCurves);
+
+        FillScenarioNormals(m_RNG, scenNumber, RandomStream::InterestRates, antithetic, normalDraws, 3);
 
         for (auto i = 0; i < numCurves; i++)
         {
-            // First generate the uncorrelated random numbers
             for (auto j = 0; j < 3; j++)
-                randNums(i, j) = InverseNormal(m_RNG.GetNext());
+                randNums(i, j) = normalDraws[3 * i + j];
                 
             // Now apply formulas to correlate the random numbers
             // The order of the next two lines was reversed before version 7.1,
@@ -118,16 +148,21 @@ void IntScenario::Generate(int scenNumber, bool testScenario, actlib::vector<dou
     // Generate future yield curves *****************************
 
     // First initialize the prior month rates
-    double oldShortRate = curves(0).rateAtIndex(3);
-    double oldLogLongRate = log(curves(0).rateAtIndex(9));
-    double oldDiff = curves(0).rateAtIndex(9) - curves(0).rateAtIndex(3);
-    double oldLogVol = curves(0).getLogVolatility();
+    double oldShortRate = curve(0).rateAtIndex(3);
+    double oldLogLongRate = log(curve(0).rateAtIndex(9));
+    double oldDiff = curve(0).rateAtIndex(9) - curve(0).rateAtIndex(3);
+    double oldLogVol = logVols(0);
 
     // Initialize the soft cap and floor on the log long rate
     double minLogLongRate = log(params.int_params.min_long_rate);
     double maxLogLongRate = log(params.int_params.max_long_rate);
     double minShortRate = params.int_params.min_short_rate;
 
+    // Constant for the run
+    double logTau1 = log(params.int_params.tau1);
+
+    // exp(oldLogLongRate); after the first month it is the previous month's newLongRate
+    double oldLongRate = exp(oldLogLongRate);
 
     // Loop by month generating new rates
     for (auto i = 0; i < numCurves; i++)
@@ -136,34 +171,33 @@ void IntScenario::Generate(int scenNumber, bool testScenario, actlib::vector<dou
         double newLogVol = (1 - params.int_params.beta3) * oldLogVol + params.const4 + randNums(i, 2) * params.int_params.sigma3;
 
         // Apply soft cap and floor on the long rate
-        double oldLongRate = exp(oldLogLongRate);
-
         // Compute the new long rate
         // (application of soft cap moved from before this calculation to just before adding the random shock February 2016)
         double newLogLongRate = std::max(minLogLongRate, std::min(maxLogLongRate, (1 - params.int_params.beta1) * oldLogLongRate + params.const5 + params.int_params.psi * (params.int_params.tau2 - oldDiff))) + (exp(newLogVol) * randNums(i, 0));
         double newLongRate = exp(newLogLongRate);
 
         // Compute the new short rate
-        double newDiff = (1 - params.int_params.beta2) * oldDiff + params.int_params.beta2 * params.int_params.tau2 + params.int_params.phi * (oldLogLongRate - log(params.int_params.tau1)) + params.int_params.sigma2 * randNums(i, 1) * pow(oldLongRate, params.int_params.theta);
+        double newDiff = (1 - params.int_params.beta2) * oldDiff + params.int_params.beta2 * params.int_params.tau2 + params.int_params.phi * (oldLogLongRate - logTau1) + params.int_params.sigma2 * randNums(i, 1) * pow(oldLongRate, params.int_params.theta);
         double newShortRate = newLongRate - newDiff;
 
         if (newShortRate < minShortRate)
             newShortRate = minShortRate; // = kappa * newLongRate
 
         // Save the new yield curve********************************
-        curves(i) = YieldCurve();
-        curves(i).Initialize(newShortRate, newLongRate, newLogVol);
+        workCurve.Initialize(newShortRate, newLongRate, newLogVol);
         
         // Note that Initialize carries out the interpolation of the 10-point curve
-        // using the Nelson-Siegel formula.
+        // using the Nelson-Siegel formula, or the historical curves if selected.
 
         // During the first 12 months, make adjustments for smooth fit to the initial curve
         if (i < 12)
-            curves(i).perturb(initialCurveFit, (12.0 - i) / 12.0);
+            workCurve.perturb(initialCurveFit, (12.0 - i) / 12.0);
 
         // Since perturb() enforces no negative interest rates, call it for later months too.
         else
-            curves(i).perturb(initialCurveFit, 0);
+            workCurve.perturb(initialCurveFit, 0);
+
+        saveCurve(i, workCurve);
 
 
         // Set up for the next month
@@ -176,31 +210,23 @@ void IntScenario::Generate(int scenNumber, bool testScenario, actlib::vector<dou
 }
 
 
-string IntScenario::serializeToJson() const
+void IntScenario::serializeToJson(JsonBuffer& out) const
 {
-    auto curveToString = [&](int curveNum) -> string
-    {
-        string s;
-        s += "\"" + std::to_string(curveNum) + "\"";
-        s += ":";
-        s += curves(curveNum).serializeToJson();
-
-        return s;
-    };
+    // Each curve is a key plus one maturity/rate pair per maturity
+    constexpr size_t maxCurveChars = 16 + YieldCurve::NumMaturities * (2 * JsonBuffer::MaxDoubleChars + 4);
 
-    string json;
+    out.reserve(out.size() + (numCurves + 1) * maxCurveChars + 4);
 
-    json += "{";
+    out.put('{');
 
-    for (auto month = curves.lower_bound(); month < curves.upper_bound(); month++)
+    for (auto month = 0; month <= numCurves; month++)
     {
-        json += curveToString(month);
-        json += ",\n";
-    }
+        out.putKey(month);
+        curve(month).serializeToJson(out);
 
-    json += curveToString(curves.upper_bound());
-
-    json += "}\n";
+        if (month != numCurves)
+            out.put(",\n");
+    }
 
-    return json;
+    out.put("}\n");
 }
@@ -1,11 +1,15 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "Vector.h"
 
 #include "C3RNG.h"
+#include "JsonBuffer.h"
+#include "SobolGenerator.h"
 #include "ScenarioGeneratorParams.hpp"
+#include "StochasticExclusionTest.h"
 #include "YieldCurve.h"
 
 using std::string;
@@ -24,19 +28,48 @@ using std::string;
 
 class IntScenario
 {
-    actlib::vector<YieldCurve> curves;
+    // The path of yield curves is stored by column rather than as one YieldCurve object per month.
+    // Row m of rates holds the 10 interpolated rates of month m, so consecutive months are adjacent in memory.
+    actlib::table<double> rates;
+    actlib::vector<double> shortRates;
+    actlib::vector<double> longRates;
+    actlib::vector<double> logVols;
     int numCurves;
 
+    // Working storage kept between calls to Generate() so that a scenario of the same length reuses it
+    YieldCurve workCurve;  // the curve being generated, before it is saved into the path
+    actlib::table<double> randNums;
+    actlib::aligned_vector<double> normalDraws;  // normal shocks for the whole scenario, 3 per month
+    actlib::vector<double> initialCurveFit = actlib::vector<double>(Range{ .lo = 1, .hi = 10 });  // Variances between NS fitted curve and actual initial curve, by duration
+
+    void saveCurve(int curveNum, const YieldCurve& yldCurve);
+
+    // Sizes the path for the projection and saves the starting curve, fitted to the initial curve, as curve 0
+    void startPath(const actlib::vector<double>& initialRateCurve, int ProjectionYears, const ScenarioGeneratorParams& params);
+
+    // IntScenarioBatch writes the paths of several scenarios directly
+    friend class IntScenarioBatch;
+
 public:
 
-    YieldCurve& curve(int curveNum);
+    YieldCurveView curve(int curveNum) const;
+
+    // Selects how each month's curve is interpolated; set once before generating
+    void setInterpolation(CurveInterpolation method, const HistCurves* HistData)
+    {
+        workCurve.setInterpolation(method, HistData);
+    }
 
     double significance();
 
+    // With antithetic set, each even scenario uses the negated draws of the odd scenario before it.
+    // With testShocks set, scenario scenNumber of the stochastic exclusion test is generated instead.
     template <typename Generator>
-    void Generate(int scenNumber, bool testScenario, actlib::vector<double> initialRateCurve, int ProjectionYears, ScenarioGeneratorParams params, Generator& m_RNG);
+    void Generate(int scenNumber, const TestShockTable* testShocks, bool antithetic, const actlib::vector<double>& initialRateCurve, int ProjectionYears, const ScenarioGeneratorParams& params, Generator& m_RNG);
 
-    _NODISCARD string serializeToJson() const;
+    void serializeToJson(JsonBuffer& out) const;
 };
 
-template void IntScenario::Generate<MersenneTwister>(int scenNumber, bool testScenario, actlib::vector<double> initialRateCurve, int ProjectionYears, ScenarioGeneratorParams params, MersenneTwister& m_RNG);
\ No newline at end of file
+template void IntScenario::Generate<MersenneTwister>(int scenNumber, const TestShockTable* testShocks, bool antithetic, const actlib::vector<double>& initialRateCurve, int ProjectionYears, const ScenarioGeneratorParams& params, MersenneTwister& m_RNG);
+template void IntScenario::Generate<Philox>(int scenNumber, const TestShockTable* testShocks, bool antithetic, const actlib::vector<double>& initialRateCurve, int ProjectionYears, const ScenarioGeneratorParams& params, Philox& m_RNG);
+template void IntScenario::Generate<SobolGenerator>(int scenNumber, const TestShockTable* testShocks, bool antithetic, const actlib::vector<double>& initialRateCurve, int ProjectionYears, const ScenarioGeneratorParams& params, SobolGenerator& m_RNG);
\ No newline at end of file
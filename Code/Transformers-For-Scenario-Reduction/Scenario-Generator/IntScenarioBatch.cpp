@@ -0,0 +1,307 @@
+#include "IntScenarioBatch.h"
+
+#include <cmath>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+#include "BatchMath.h"
+
+
+namespace
+{
+    using namespace batch_math;
+
+    constexpr int Lanes = IntScenarioBatch::Lanes;
+    constexpr int NumMaturities = YieldCurve::NumMaturities;
+
+    constexpr double MinRate = 0.0001;  // the floor YieldCurve applies to every rate
+
+
+    // The parameters of the monthly recursion, with every constant of IntScenario::Generate() worked out once
+    struct RateRecursion
+    {
+        double volDecay, volConst, sigma3;
+        double longDecay, longConst, psi, tau2;
+        double minLogLongRate, maxLogLongRate;
+        double diffDecay, diffConst, phi, logTau1, sigma2, theta;
+        double minShortRate;
+
+        double nsConst1;                         // Nelson-Siegel loading of the 1 year rate
+        double nsInvSpread;                      // 1 / (const1 - const20)
+        double nsLoading[NumMaturities];         // (1 - exp(-k t)) / (k t)
+        double curveFit[NumMaturities];          // initialCurveFit, phased out over the first 12 months
+
+        double startLogLongRate, startDiff, startLogVol;  // the same for every scenario
+    };
+
+
+    // Where a lane writes its path: consecutive months of the arrays in its IntScenario
+    struct LanePath
+    {
+        double* rates;       // NumMaturities per month
+        double* shortRates;
+        double* longRates;
+        double* logVols;
+    };
+
+
+    // The recursion of IntScenario::Generate() for one lane at a time
+    void advanceScalar(const RateRecursion& rr, const double* shocks, int numMonths, const LanePath* paths, int count)
+    {
+        for (int l = 0; l < count; l++)
+        {
+            const LanePath& path = paths[l];
+
+            double oldLogLongRate = rr.startLogLongRate;
+            double oldDiff = rr.startDiff;
+            double oldLogVol = rr.startLogVol;
+
+            for (int m = 0; m < numMonths; m++)
+            {
+                const double* z = shocks + 3 * m * Lanes + l;
+
+                double newLogVol = rr.volDecay * oldLogVol + rr.volConst + z[2 * Lanes] * rr.sigma3;
+
+                double capped = maxScalar(minScalar(rr.longDecay * oldLogLongRate + rr.longConst + rr.psi * (rr.tau2 - oldDiff), rr.maxLogLongRate), rr.minLogLongRate);
+                double newLogLongRate = capped + expScalar(newLogVol) * z[0];
+                double newLongRate = expScalar(newLogLongRate);
+
+                double newDiff = rr.diffDecay * oldDiff + rr.diffConst + rr.phi * (oldLogLongRate - rr.logTau1) + rr.sigma2 * z[Lanes] * expScalar(rr.theta * oldLogLongRate);
+                double newShortRate = maxScalar(newLongRate - newDiff, rr.minShortRate);
+
+                // YieldCurve::Initialize() and interpolateNS()
+                double r1 = maxScalar(newShortRate, MinRate);
+                double r20 = maxScalar(newLongRate, MinRate);
+
+                double b1 = (r1 - r20) * rr.nsInvSpread;
+                double b0 = r1 - b1 * rr.nsConst1;
+
+                double portion = m < 12 ? (12.0 - m) / 12.0 : 0;
+
+                double* rates = path.rates + m * NumMaturities;
+
+                for (int j = 0; j < NumMaturities; j++)
+                    rates[j] = maxScalar(b0 + b1 * rr.nsLoading[j] + portion * rr.curveFit[j], MinRate);
+
+                path.shortRates[m] = r1;
+                path.longRates[m] = r20;
+                path.logVols[m] = newLogVol;
+
+                oldLogLongRate = newLogLongRate;
+                oldDiff = newDiff;
+                oldLogVol = newLogVol;
+            }
+        }
+    }
+
+
+#ifdef SIMD_AVX2
+
+    // advanceScalar() with the four lanes in one register.  min and max take the second operand
+    // when either is NaN, which is what minScalar() and maxScalar() do.
+    TARGET_AVX2 void advanceAvx2(const RateRecursion& rr, const double* shocks, int numMonths, const LanePath* paths, int count)
+    {
+        const __m256d volDecay = _mm256_set1_pd(rr.volDecay);
+        const __m256d volConst = _mm256_set1_pd(rr.volConst);
+        const __m256d sigma3 = _mm256_set1_pd(rr.sigma3);
+        const __m256d longDecay = _mm256_set1_pd(rr.longDecay);
+        const __m256d longConst = _mm256_set1_pd(rr.longConst);
+        const __m256d psi = _mm256_set1_pd(rr.psi);
+        const __m256d tau2 = _mm256_set1_pd(rr.tau2);
+        const __m256d minLogLongRate = _mm256_set1_pd(rr.minLogLongRate);
+        const __m256d maxLogLongRate = _mm256_set1_pd(rr.maxLogLongRate);
+        const __m256d diffDecay = _mm256_set1_pd(rr.diffDecay);
+        const __m256d diffConst = _mm256_set1_pd(rr.diffConst);
+        const __m256d phi = _mm256_set1_pd(rr.phi);
+        const __m256d logTau1 = _mm256_set1_pd(rr.logTau1);
+        const __m256d sigma2 = _mm256_set1_pd(rr.sigma2);
+        const __m256d theta = _mm256_set1_pd(rr.theta);
+        const __m256d minShortRate = _mm256_set1_pd(rr.minShortRate);
+        const __m256d minRate = _mm256_set1_pd(MinRate);
+        const __m256d nsInvSpread = _mm256_set1_pd(rr.nsInvSpread);
+        const __m256d nsConst1 = _mm256_set1_pd(rr.nsConst1);
+
+        __m256d oldLogLongRate = _mm256_set1_pd(rr.startLogLongRate);
+        __m256d oldDiff = _mm256_set1_pd(rr.startDiff);
+        __m256d oldLogVol = _mm256_set1_pd(rr.startLogVol);
+
+        // One month of results, by maturity then lane, copied out to each lane's path
+        alignas(32) double rates[NumMaturities][Lanes];
+        alignas(32) double shortRates[Lanes], longRates[Lanes], logVols[Lanes];
+
+        for (int m = 0; m < numMonths; m++)
+        {
+            const double* z = shocks + 3 * m * Lanes;
+
+            __m256d z0 = _mm256_loadu_pd(z);
+            __m256d z1 = _mm256_loadu_pd(z + Lanes);
+            __m256d z2 = _mm256_loadu_pd(z + 2 * Lanes);
+
+            __m256d newLogVol = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(volDecay, oldLogVol), volConst), _mm256_mul_pd(z2, sigma3));
+
+            __m256d target = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(longDecay, oldLogLongRate), longConst), _mm256_mul_pd(psi, _mm256_sub_pd(tau2, oldDiff)));
+            __m256d capped = _mm256_max_pd(_mm256_min_pd(target, maxLogLongRate), minLogLongRate);
+            __m256d newLogLongRate = _mm256_add_pd(capped, _mm256_mul_pd(expAvx2(newLogVol), z0));
+            __m256d newLongRate = expAvx2(newLogLongRate);
+
+            __m256d newDiff = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(diffDecay, oldDiff), diffConst),
+                                                          _mm256_mul_pd(phi, _mm256_sub_pd(oldLogLongRate, logTau1))),
+                                            _mm256_mul_pd(_mm256_mul_pd(sigma2, z1), expAvx2(_mm256_mul_pd(theta, oldLogLongRate))));
+            __m256d newShortRate = _mm256_max_pd(_mm256_sub_pd(newLongRate, newDiff), minShortRate);
+
+            __m256d r1 = _mm256_max_pd(newShortRate, minRate);
+            __m256d r20 = _mm256_max_pd(newLongRate, minRate);
+
+            __m256d b1 = _mm256_mul_pd(_mm256_sub_pd(r1, r20), nsInvSpread);
+            __m256d b0 = _mm256_sub_pd(r1, _mm256_mul_pd(b1, nsConst1));
+
+            __m256d portion = _mm256_set1_pd(m < 12 ? (12.0 - m) / 12.0 : 0);
+
+            for (int j = 0; j < NumMaturities; j++)
+            {
+                __m256d rate = _mm256_add_pd(b0, _mm256_mul_pd(b1, _mm256_set1_pd(rr.nsLoading[j])));
+                rate = _mm256_add_pd(rate, _mm256_mul_pd(portion, _mm256_set1_pd(rr.curveFit[j])));
+
+                _mm256_store_pd(rates[j], _mm256_max_pd(rate, minRate));
+            }
+
+            _mm256_store_pd(shortRates, r1);
+            _mm256_store_pd(longRates, r20);
+            _mm256_store_pd(logVols, newLogVol);
+
+            for (int l = 0; l < count; l++)
+            {
+                double* out = paths[l].rates + m * NumMaturities;
+
+                for (int j = 0; j < NumMaturities; j++)
+                    out[j] = rates[j][l];
+
+                paths[l].shortRates[m] = shortRates[l];
+                paths[l].longRates[m] = longRates[l];
+                paths[l].logVols[m] = logVols[l];
+            }
+
+            oldLogLongRate = newLogLongRate;
+            oldDiff = newDiff;
+            oldLogVol = newLogVol;
+        }
+    }
+
+#endif
+
+
+    using RecursionKernel = void (*)(const RateRecursion&, const double*, int, const LanePath*, int);
+
+    RecursionKernel selectRecursionKernel()
+    {
+#ifdef SIMD_AVX2
+        if (cpuHasAvx2())
+            return advanceAvx2;
+#endif
+        return advanceScalar;
+    }
+}
+
+
+template <typename Generator>
+void IntScenarioBatch::Generate(int firstScenario, int count, const TestShockTable* testShocks, bool antithetic, const actlib::vector<double>& initialRateCurve, int ProjectionYears, const ScenarioGeneratorParams& params, Generator& m_RNG)
+{
+    static const RecursionKernel kernel = selectRecursionKernel();
+
+    if (count < 1 || count > Lanes)
+        throw std::invalid_argument("IntScenarioBatch: a batch holds 1 to " + std::to_string(Lanes) + " scenarios");
+
+    for (int l = 0; l < count; l++)
+        scenarios[l].startPath(initialRateCurve, ProjectionYears, params);
+
+    const IntScenario& first = scenarios[0];
+    int numMonths = first.numCurves;
+
+    // Draw each scenario's numbers from its own seed and correlate them as IntScenario::Generate() does,
+    // interleaving the lanes.  Unused lanes get zero shocks, and their results are not kept.
+    normalDraws.resize(3 * numMonths);
+    shocks.assign(3 * numMonths * Lanes, 0.);
+
+    if (testShocks && testShocks->getNumMonths() < numMonths)
+        throw std::invalid_argument("the stochastic exclusion test shocks are shorter than the projection");
+
+    for (int l = 0; l < count; l++)
+    {
+        if (testShocks)
+        {
+            std::span<const double> longShocks = testShocks->path(firstScenario + l, LongIntShock);
+            std::span<const double> diffShocks = testShocks->path(firstScenario + l, IntDiffShock);
+
+            // As IntScenario::Generate() sets them up; the volatility shocks stay zero
+            for (int i = 0; i < numMonths; i++)
+            {
+                shocks[(3 * i) * Lanes + l]     = longShocks[i];
+                shocks[(3 * i + 1) * Lanes + l] = longShocks[i] * params.correl12 + diffShocks[i] * params.const1;
+            }
+
+            continue;
+        }
+
+        FillScenarioNormals(m_RNG, firstScenario + l, RandomStream::InterestRates, antithetic, normalDraws, 3);
+
+        for (int i = 0; i < numMonths; i++)
+        {
+            double z0 = normalDraws[3 * i];
+            double z1 = normalDraws[3 * i + 1];
+            double z2 = normalDraws[3 * i + 2];
+
+            shocks[(3 * i) * Lanes + l]     = z0;
+            shocks[(3 * i + 1) * Lanes + l] = z0 * params.correl12 + z1 * params.const1;
+            shocks[(3 * i + 2) * Lanes + l] = z0 * params.correl13 + z1 * params.const2 + z2 * params.const3;
+        }
+    }
+
+    const YieldCurve::NelsonSiegelTerms& nst = YieldCurve::nelsonSiegelTerms();
+    const auto& ip = params.int_params;
+
+    RateRecursion rr;
+
+    rr.volDecay = 1 - ip.beta3;
+    rr.volConst = params.const4;
+    rr.sigma3 = ip.sigma3;
+    rr.longDecay = 1 - ip.beta1;
+    rr.longConst = params.const5;
+    rr.psi = ip.psi;
+    rr.tau2 = ip.tau2;
+    rr.minLogLongRate = log(ip.min_long_rate);
+    rr.maxLogLongRate = log(ip.max_long_rate);
+    rr.diffDecay = 1 - ip.beta2;
+    rr.diffConst = ip.beta2 * ip.tau2;
+    rr.phi = ip.phi;
+    rr.logTau1 = log(ip.tau1);
+    rr.sigma2 = ip.sigma2;
+    rr.theta = ip.theta;
+    rr.minShortRate = ip.min_short_rate;
+
+    rr.nsConst1 = nst.const1;
+    rr.nsInvSpread = 1 / (nst.const1 - nst.const20);
+
+    for (int j = 0; j < NumMaturities; j++)
+    {
+        rr.nsLoading[j] = (1 - nst.decay[j]) / nst.kt[j];
+        rr.curveFit[j] = first.initialCurveFit(j + 1);
+    }
+
+    // Every scenario starts from the same curve
+    rr.startLogLongRate = log(first.curve(0).rateAtIndex(9));
+    rr.startDiff = first.curve(0).rateAtIndex(9) - first.curve(0).rateAtIndex(3);
+    rr.startLogVol = first.logVols(0);
+
+    // As in IntScenario::Generate(), the curve for month i + 1 is saved as curve i
+    LanePath paths[Lanes];
+
+    for (int l = 0; l < count; l++)
+    {
+        IntScenario& scn = scenarios[l];
+
+        paths[l] = LanePath{ &scn.rates(0, 1), &scn.shortRates(0), &scn.longRates(0), &scn.logVols(0) };
+    }
+
+    kernel(rr, shocks.data(), numMonths, paths, count);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "Vector.h"
+
+#include "C3RNG.h"
+#include "IntScenario.h"
+#include "ScenarioGeneratorParams.hpp"
+#include "SobolGenerator.h"
+
+/**
+ * Generates the interest rate paths of several stochastic scenarios at once.
+ *
+ * The month-by-month recursion in IntScenario::Generate() is a chain of dependent
+ * exponentials, so one scenario cannot keep a core busy.  Scenarios are independent,
+ * though, so this class advances Lanes scenarios in lockstep, one scenario per lane of
+ * an AVX2 register, with the caps and floors as vector min and max.  BatchMath.h says why a
+ * path does not depend on its batch or on the CPU.
+ *
+ * The exponentials use a polynomial rather than the C library, and pow(exp(a), theta) is
+ * computed as exp(theta * a), so the paths agree with IntScenario::Generate() to about
+ * 1e-15 rather than exactly.  Only Nelson-Siegel interpolation is supported; historical
+ * interpolation uses IntScenario::Generate().  Stochastic exclusion test scenarios go through
+ * the same recursion with their shocks read from a TestShockTable instead of drawn.
+ */
+
+class IntScenarioBatch
+{
+public:
+
+    static constexpr int Lanes = 4;
+
+private:
+
+    std::array<IntScenario, Lanes> scenarios;
+
+    actlib::aligned_vector<double> normalDraws;  // one scenario's uncorrelated draws, 3 per month
+    actlib::aligned_vector<double> shocks;       // correlated shocks for month m, process p, lane l at (3 * m + p) * Lanes + l
+
+public:
+
+    // Generates scenarios firstScenario to firstScenario + count - 1 into lanes 0 to count - 1.
+    // count is at most Lanes.  With testShocks set they are stochastic exclusion test scenarios.
+    template <typename Generator>
+    void Generate(int firstScenario, int count, const TestShockTable* testShocks, bool antithetic, const actlib::vector<double>& initialRateCurve, int ProjectionYears, const ScenarioGeneratorParams& params, Generator& m_RNG);
+
+    const IntScenario& scenario(int lane) const
+    {
+        return scenarios[lane];
+    }
+};
+
+template void IntScenarioBatch::Generate<MersenneTwister>(int firstScenario, int count, const TestShockTable* testShocks, bool antithetic, const actlib::vector<double>& initialRateCurve, int ProjectionYears, const ScenarioGeneratorParams& params, MersenneTwister& m_RNG);
+template void IntScenarioBatch::Generate<Philox>(int firstScenario, int count, const TestShockTable* testShocks, bool antithetic, const actlib::vector<double>& initialRateCurve, int ProjectionYears, const ScenarioGeneratorParams& params, Philox& m_RNG);
+template void IntScenarioBatch::Generate<SobolGenerator>(int firstScenario, int count, const TestShockTable* testShocks, bool antithetic, const actlib::vector<double>& initialRateCurve, int ProjectionYears, const ScenarioGeneratorParams& params, SobolGenerator& m_RNG);
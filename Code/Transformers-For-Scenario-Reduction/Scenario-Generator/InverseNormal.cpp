@@ -0,0 +1,205 @@
+#include "InverseNormal.h"
+
+#include <cmath>
+#include <stdexcept>
+
+#include "CpuFeatures.h"
+
+
+namespace
+{
+    // Define coefficients in rational approximations
+    constexpr double a1 = -39.6968302866538;
+    constexpr double a2 = 220.946098424521;
+    constexpr double a3 = -275.928510446969;
+    constexpr double a4 = 138.357751867269;
+    constexpr double a5 = -30.6647980661472;
+    constexpr double a6 = 2.50662827745924;
+
+    constexpr double b1 = -54.4760987982241;
+    constexpr double b2 = 161.585836858041;
+    constexpr double b3 = -155.698979859887;
+    constexpr double b4 = 66.8013118877197;
+    constexpr double b5 = -13.2806815528857;
+
+    constexpr double c1 = -7.78489400243029E-03;
+    constexpr double c2 = -0.322396458041136;
+    constexpr double c3 = -2.40075827716184;
+    constexpr double c4 = -2.54973253934373;
+    constexpr double c5 = 4.37466414146497;
+    constexpr double c6 = 2.93816398269878;
+
+    constexpr double d1 = 7.78469570904146E-03;
+    constexpr double d2 = 0.32246712907004;
+    constexpr double d3 = 2.445134137143;
+    constexpr double d4 = 3.75440866190742;
+
+    // Define break-points
+    constexpr double p_low = 0.02425;
+    constexpr double p_high = 1 - p_low;
+
+
+    [[noreturn]] void throwOutOfRange()
+    {
+        throw std::out_of_range("InverseNormal: probability must be strictly between 0 and 1");
+    }
+
+
+    void inverseNormalScalar(const double* p, double* out, size_t n)
+    {
+        for (size_t i = 0; i < n; i++)
+            out[i] = InverseNormal(p[i]);
+    }
+
+
+#ifdef SIMD_AVX2
+
+    // The operations below are the same multiplies, adds and divides, in the same order,
+    // as the scalar version, so each lane gives exactly the scalar result.  No FMA is used
+    // because fusing would change the rounding.
+    TARGET_AVX2 void inverseNormalAvx2(const double* p, double* out, size_t n)
+    {
+        const __m256d zero  = _mm256_setzero_pd();
+        const __m256d one   = _mm256_set1_pd(1);
+        const __m256d half  = _mm256_set1_pd(0.5);
+        const __m256d low   = _mm256_set1_pd(p_low);
+        const __m256d high  = _mm256_set1_pd(p_high);
+        const __m256d signs = _mm256_set1_pd(-0.0);
+
+        size_t i = 0;
+
+        for (; i + 4 <= n; i += 4)
+        {
+            __m256d x = _mm256_loadu_pd(p + i);
+
+            // Both comparisons are false for NaN, so NaN is rejected too
+            __m256d inRange = _mm256_and_pd(_mm256_cmp_pd(x, zero, _CMP_GT_OQ), _mm256_cmp_pd(x, one, _CMP_LT_OQ));
+
+            if (_mm256_movemask_pd(inRange) != 0xF)
+                throwOutOfRange();
+
+            // Rational approximation for central region, computed for every lane
+            __m256d q = _mm256_sub_pd(x, half);
+            __m256d r = _mm256_mul_pd(q, q);
+
+            __m256d num = _mm256_set1_pd(a1);
+            num = _mm256_add_pd(_mm256_mul_pd(num, r), _mm256_set1_pd(a2));
+            num = _mm256_add_pd(_mm256_mul_pd(num, r), _mm256_set1_pd(a3));
+            num = _mm256_add_pd(_mm256_mul_pd(num, r), _mm256_set1_pd(a4));
+            num = _mm256_add_pd(_mm256_mul_pd(num, r), _mm256_set1_pd(a5));
+            num = _mm256_add_pd(_mm256_mul_pd(num, r), _mm256_set1_pd(a6));
+            num = _mm256_mul_pd(num, q);
+
+            __m256d den = _mm256_set1_pd(b1);
+            den = _mm256_add_pd(_mm256_mul_pd(den, r), _mm256_set1_pd(b2));
+            den = _mm256_add_pd(_mm256_mul_pd(den, r), _mm256_set1_pd(b3));
+            den = _mm256_add_pd(_mm256_mul_pd(den, r), _mm256_set1_pd(b4));
+            den = _mm256_add_pd(_mm256_mul_pd(den, r), _mm256_set1_pd(b5));
+            den = _mm256_add_pd(_mm256_mul_pd(den, r), one);
+
+            __m256d result = _mm256_div_pd(num, den);
+
+            __m256d isLower = _mm256_cmp_pd(x, low, _CMP_LT_OQ);
+            __m256d isUpper = _mm256_cmp_pd(x, high, _CMP_GT_OQ);
+            __m256d isTail  = _mm256_or_pd(isLower, isUpper);
+
+            int tailLanes = _mm256_movemask_pd(isTail);
+
+            // About one block in six has a tail value
+            if (tailLanes != 0)
+            {
+                // AVX2 has no logarithm instruction, so the tail lanes take theirs one at a time
+                alignas(32) double tq[4];
+
+                for (int k = 0; k < 4; k++)
+                {
+                    double pk = p[i + k];
+                    tq[k] = (tailLanes & (1 << k)) ? sqrt(-2 * log(pk < p_low ? pk : 1 - pk)) : 1;
+                }
+
+                __m256d qt = _mm256_load_pd(tq);
+
+                __m256d tnum = _mm256_set1_pd(c1);
+                tnum = _mm256_add_pd(_mm256_mul_pd(tnum, qt), _mm256_set1_pd(c2));
+                tnum = _mm256_add_pd(_mm256_mul_pd(tnum, qt), _mm256_set1_pd(c3));
+                tnum = _mm256_add_pd(_mm256_mul_pd(tnum, qt), _mm256_set1_pd(c4));
+                tnum = _mm256_add_pd(_mm256_mul_pd(tnum, qt), _mm256_set1_pd(c5));
+                tnum = _mm256_add_pd(_mm256_mul_pd(tnum, qt), _mm256_set1_pd(c6));
+
+                __m256d tden = _mm256_set1_pd(d1);
+                tden = _mm256_add_pd(_mm256_mul_pd(tden, qt), _mm256_set1_pd(d2));
+                tden = _mm256_add_pd(_mm256_mul_pd(tden, qt), _mm256_set1_pd(d3));
+                tden = _mm256_add_pd(_mm256_mul_pd(tden, qt), _mm256_set1_pd(d4));
+                tden = _mm256_add_pd(_mm256_mul_pd(tden, qt), one);
+
+                // The upper tail is the negated lower-tail formula
+                tnum = _mm256_blendv_pd(tnum, _mm256_xor_pd(tnum, signs), isUpper);
+
+                result = _mm256_blendv_pd(result, _mm256_div_pd(tnum, tden), isTail);
+            }
+
+            _mm256_storeu_pd(out + i, result);
+        }
+
+        inverseNormalScalar(p + i, out + i, n - i);
+    }
+
+#endif
+
+
+    using BatchKernel = void (*)(const double*, double*, size_t);
+
+    BatchKernel selectBatchKernel()
+    {
+#ifdef SIMD_AVX2
+        if (cpuHasAvx2())
+            return inverseNormalAvx2;
+#endif
+        return inverseNormalScalar;
+    }
+}
+
+
+// The inverse normal routine in Excel is poor -- this version is much better.
+double InverseNormal(double p)
+{
+    // Adapted for Microsoft Visual Basic from Peter Acklam's
+    // "An algorithm for computing the inverse normal cumulative distribution function"
+    // (http://home.online.no/~pjacklam/notes/invnorm/)
+    // by John Herrero (3-Jan-03)
+
+    // If argument out of bounds, raise error
+    if (!(p > 0 && p < 1))
+        throwOutOfRange();
+
+    if (p < p_low)
+    {
+        // Rational approximation for lower region
+        double q = sqrt(-2 * log(p));
+        return (((((c1 * q + c2) * q + c3) * q + c4) * q + c5) * q + c6) / ((((d1 * q + d2) * q + d3) * q + d4) * q + 1);
+    }
+    else if (p <= p_high)
+    {
+        // Rational approximation for central region
+        double q = p - 0.5;
+        double r = q * q;
+        return (((((a1 * r + a2) * r + a3) * r + a4) * r + a5) * r + a6) * q / (((((b1 * r + b2) * r + b3) * r + b4) * r + b5) * r + 1);
+    }
+    else
+    {
+        // Rational approximation for upper region
+        double q = sqrt(-2 * log(1 - p));
+        return -(((((c1 * q + c2) * q + c3) * q + c4) * q + c5) * q + c6) / ((((d1 * q + d2) * q + d3) * q + d4) * q + 1);
+    }
+}
+
+
+void InverseNormal(std::span<const double> p, std::span<double> out)
+{
+    static const BatchKernel kernel = selectBatchKernel();
+
+    if (p.size() != out.size())
+        throw std::invalid_argument("InverseNormal: input and output sizes differ");
+
+    kernel(p.data(), out.data(), p.size());
+}
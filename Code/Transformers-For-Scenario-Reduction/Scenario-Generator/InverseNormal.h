@@ -0,0 +1,20 @@
+#pragma once
+
+#include <span>
+
+/**
+ * Inverse of the standard normal cumulative distribution function, using
+ * Peter Acklam's rational approximation.
+ *
+ * The batch version converts a whole array of uniforms at once.  On CPUs with
+ * AVX2 it evaluates four values per instruction, and it falls back to the scalar
+ * version elsewhere; the choice is made once at run time.  Both versions give
+ * bit-identical results, so the generated scenarios do not depend on the CPU.
+ *
+ * Both throw std::out_of_range if a probability is not strictly between 0 and 1.
+ */
+
+double InverseNormal(double p);
+
+// out may be the same array as p.  The two spans must have the same size.
+void InverseNormal(std::span<const double> p, std::span<double> out);
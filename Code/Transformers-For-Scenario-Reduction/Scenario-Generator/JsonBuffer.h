@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * A reusable character buffer for serializing scenarios to JSON.
+ *
+ * Numbers are formatted in place with std::to_chars, which gives the shortest text that reads
+ * back to the same double, so no temporary strings are created.  The buffer keeps its capacity
+ * when cleared; once a worker's buffer has grown to fit one scenario, serializing the following
+ * scenarios does not allocate.  Buffers are moved rather than copied, and a moved-from buffer is
+ * left empty.
+ */
+
+class JsonBuffer
+{
+    std::vector<char> buf;
+    size_t len = 0;
+
+    char* ensure(size_t n)
+    {
+        if (len + n > buf.size())
+            buf.resize(std::max(2 * buf.size(), len + n));
+
+        return buf.data() + len;
+    }
+
+public:
+
+    JsonBuffer() = default;
+
+    JsonBuffer(JsonBuffer&& other) noexcept :
+        buf(std::move(other.buf)),
+        len(std::exchange(other.len, 0))
+    {
+
+    }
+
+    JsonBuffer& operator=(JsonBuffer&& other) noexcept
+    {
+        buf = std::move(other.buf);
+        len = std::exchange(other.len, 0);
+        return *this;
+    }
+
+    // Longest output of std::to_chars for a double in shortest round-trip form, e.g. -2.2250738585072014e-308
+    static constexpr size_t MaxDoubleChars = 24;
+
+    void clear()
+    {
+        len = 0;
+    }
+
+    void reserve(size_t n)
+    {
+        if (n > buf.size())
+            buf.resize(n);
+    }
+
+    const char* data() const
+    {
+        return buf.data();
+    }
+
+    size_t size() const
+    {
+        return len;
+    }
+
+    std::string_view view() const
+    {
+        return std::string_view(buf.data(), len);
+    }
+
+    void put(char c)
+    {
+        *ensure(1) = c;
+        len++;
+    }
+
+    void put(std::string_view s)
+    {
+        std::copy(s.begin(), s.end(), ensure(s.size()));
+        len += s.size();
+    }
+
+    void putNumber(double d)
+    {
+        // JSON has no representation for NaN or infinity, and the GMIB reader expects a number
+        // for every month, so a non-finite value is an error in the scenario rather than a gap
+        if (!std::isfinite(d))
+            throw std::domain_error("cannot write " + std::to_string(d) + " to a JSON scenario file");
+
+        char* first = ensure(MaxDoubleChars);
+        len = std::to_chars(first, first + MaxDoubleChars, d).ptr - buf.data();
+    }
+
+    void putNumber(int i)
+    {
+        char* first = ensure(12);
+        len = std::to_chars(first, first + 12, i).ptr - buf.data();
+    }
+
+    // Writes a number as a quoted JSON object key
+    template <typename T>
+    void putKey(T number)
+    {
+        put('"');
+        putNumber(number);
+        put("\":");
+    }
+};
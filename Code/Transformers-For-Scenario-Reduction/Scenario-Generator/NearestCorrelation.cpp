@@ -0,0 +1,185 @@
+#include "NearestCorrelation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+
+namespace
+{
+    constexpr int MaxIterations = 1000;
+    constexpr double ConvergenceTolerance = 1e-12;
+
+    // A symmetric n x n matrix stored row by row
+    struct Matrix
+    {
+        int n;
+        std::vector<double> a;
+
+        explicit Matrix(int size) : n(size), a(size * size, 0.) {}
+
+        double& operator()(int i, int j)       { return a[i * n + j]; }
+        double operator()(int i, int j) const  { return a[i * n + j]; }
+    };
+
+
+    // Cyclic Jacobi eigenvalue method.  On return values holds the eigenvalues and the
+    // columns of vectors the eigenvectors.  The matrices here are small (11 x 11 for
+    // the fund returns), so the simplicity is worth more than the speed of QR.
+    void symmetricEigen(Matrix m, std::vector<double>& values, Matrix& vectors)
+    {
+        int n = m.n;
+
+        vectors = Matrix(n);
+        for (int i = 0; i < n; i++)
+            vectors(i, i) = 1;
+
+        for (int sweep = 0; sweep < 100; sweep++)
+        {
+            double offDiagonal = 0;
+
+            for (int p = 0; p < n; p++)
+                for (int q = p + 1; q < n; q++)
+                    offDiagonal += m(p, q) * m(p, q);
+
+            if (offDiagonal < 1e-30)
+                break;
+
+            for (int p = 0; p < n; p++)
+            {
+                for (int q = p + 1; q < n; q++)
+                {
+                    if (m(p, q) == 0)
+                        continue;
+
+                    // Rotation that zeroes m(p, q)
+                    double theta = (m(q, q) - m(p, p)) / (2 * m(p, q));
+                    double t = (theta >= 0 ? 1 : -1) / (std::abs(theta) + sqrt(theta * theta + 1));
+                    double c = 1 / sqrt(t * t + 1);
+                    double s = t * c;
+
+                    for (int k = 0; k < n; k++)
+                    {
+                        double mkp = m(k, p);
+                        double mkq = m(k, q);
+                        m(k, p) = c * mkp - s * mkq;
+                        m(k, q) = s * mkp + c * mkq;
+                    }
+
+                    for (int k = 0; k < n; k++)
+                    {
+                        double mpk = m(p, k);
+                        double mqk = m(q, k);
+                        m(p, k) = c * mpk - s * mqk;
+                        m(q, k) = s * mpk + c * mqk;
+                    }
+
+                    for (int k = 0; k < n; k++)
+                    {
+                        double vkp = vectors(k, p);
+                        double vkq = vectors(k, q);
+                        vectors(k, p) = c * vkp - s * vkq;
+                        vectors(k, q) = s * vkp + c * vkq;
+                    }
+                }
+            }
+        }
+
+        values.resize(n);
+        for (int i = 0; i < n; i++)
+            values[i] = m(i, i);
+    }
+
+
+    // Projection onto the symmetric matrices with every eigenvalue at least minEigenvalue
+    Matrix clipEigenvalues(const Matrix& m, double minEigenvalue)
+    {
+        std::vector<double> values;
+        Matrix vectors(m.n);
+
+        symmetricEigen(m, values, vectors);
+
+        Matrix result(m.n);
+
+        for (int i = 0; i < m.n; i++)
+            for (int j = 0; j < m.n; j++)
+                for (int k = 0; k < m.n; k++)
+                    result(i, j) += vectors(i, k) * std::max(values[k], minEigenvalue) * vectors(j, k);
+
+        return result;
+    }
+
+
+    // Scales rows and columns so the diagonal is 1, which keeps the matrix positive definite
+    void scaleToUnitDiagonal(Matrix& m)
+    {
+        std::vector<double> scale(m.n);
+
+        for (int i = 0; i < m.n; i++)
+            scale[i] = 1 / sqrt(m(i, i));
+
+        for (int i = 0; i < m.n; i++)
+            for (int j = 0; j < m.n; j++)
+                m(i, j) *= scale[i] * scale[j];
+    }
+}
+
+
+actlib::table<double> NearestCorrelationMatrix(const actlib::table<double>& correlations)
+{
+    if (correlations.size(1) != correlations.size(2))
+        throw std::invalid_argument("correlation matrix is not square");
+
+    int n = correlations.size(1);
+
+    Matrix y(n);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            y(i, j) = 0.5 * (correlations(i, j) + correlations(j, i));
+
+    Matrix correction(n);  // Dykstra's correction to the positive semidefinite projection
+
+    for (int iteration = 0; iteration < MaxIterations; iteration++)
+    {
+        Matrix r = y;
+        for (int k = 0; k < n * n; k++)
+            r.a[k] -= correction.a[k];
+
+        Matrix x = clipEigenvalues(r, 0);
+
+        for (int k = 0; k < n * n; k++)
+            correction.a[k] = x.a[k] - r.a[k];
+
+        // Projection onto the matrices with a unit diagonal
+        Matrix next = x;
+        for (int i = 0; i < n; i++)
+            next(i, i) = 1;
+
+        double change = 0;
+        double size = 0;
+
+        for (int k = 0; k < n * n; k++)
+        {
+            change += (next.a[k] - y.a[k]) * (next.a[k] - y.a[k]);
+            size += next.a[k] * next.a[k];
+        }
+
+        y = next;
+
+        if (change <= ConvergenceTolerance * ConvergenceTolerance * size)
+            break;
+    }
+
+    // The limit is only positive semidefinite, so lift the smallest eigenvalues before it is factored
+    Matrix result = clipEigenvalues(y, MinEigenvalue);
+    scaleToUnitDiagonal(result);
+
+    actlib::table<double> repaired(n, n);
+
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            repaired(i, j) = 0.5 * (result(i, j) + result(j, i));
+
+    return repaired;
+}
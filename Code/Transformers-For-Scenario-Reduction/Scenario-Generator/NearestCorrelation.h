@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Table.h"
+
+/**
+ * Repairs a correlation matrix that is not positive definite, as happens when
+ * correlations are estimated pairwise or edited by hand.
+ *
+ * Uses Higham's alternating projections method (with Dykstra's correction) to
+ * find the nearest correlation matrix in the Frobenius norm, then lifts the
+ * smallest eigenvalues to MinEigenvalue so that the result can be factored.
+ * The input must be square and symmetric.
+ */
+
+// The smallest eigenvalue the repaired matrix is allowed to have
+constexpr double MinEigenvalue = 1e-6;
+
+actlib::table<double> NearestCorrelationMatrix(const actlib::table<double>& correlations);
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "Table.h"
+#include "json.hpp"
+
+#include "ScenarioGeneratorParams.hpp"
+
+using json = nlohmann::json;
+
+// Reads the interest rate, equity and bond fund parameters from a parameter file such as params.json
+ScenarioGeneratorParams readScenarioGeneratorParams(const json& data);
+
+// Reads the 11 x 11 fund return correlation matrix from a parameter file
+actlib::table<double> readCorrelationMatrix(const json& data);
@@ -1,178 +1,247 @@
 #include "ScenarioGenerator.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <exception>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <stdexcept>
 #include <thread>
 
 #include "HistCurves.h"
+#include "NearestCorrelation.h"
 
 using std::ofstream;
 
 map<Date, double> naicMeanReversionPoints;
 
-// The inverse normal routine in Excel is poor -- this version is much better.
-double InverseNormal(double p)
+
+void ScenarioGenerator::loadHistoricalCurves(const string& historyDir, const string& historyFile)
+{
+    constexpr Date April1953 {.month = APRIL, .year = 1953};  // date of the first rate in the per-maturity files
+
+    auto StartTime = std::chrono::steady_clock::now();
+
+    if (historyFile.empty())
+        HistData.LoadMaturityFiles(historyDir, April1953);
+    else
+        HistData.Load(historyFile);
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - StartTime;
+
+    std::cout << "Loaded " << HistData.getNumCurves() << " historical curves in " << std::fixed << std::setprecision(1) << elapsed.count() << " ms\n" << std::defaultfloat;
+}
+
+
+void ScenarioGenerator::saveHistoricalCurves(const string& filename) const
+{
+    HistData.Save(filename);
+}
+
+
+void ScenarioGenerator::valueScenarios(const ValuationParams& params, bool writeFiles)
+{
+    valuationParams = params;
+    writeScenarioFiles = writeFiles;
+}
+
+
+ScenarioWorkerContext ScenarioGenerator::makeWorkerContext(const string& output_dir) const
 {
-    // Adapted for Microsoft Visual Basic from Peter Acklam's
-    // "An algorithm for computing the inverse normal cumulative distribution function"
-    // (http://home.online.no/~pjacklam/notes/invnorm/)
-    // by John Herrero (3-Jan-03)
-
-    // Define coefficients in rational approximations
-    constexpr double a1 = -39.6968302866538;
-    constexpr double a2 = 220.946098424521;
-    constexpr double a3 = -275.928510446969;
-    constexpr double a4 = 138.357751867269;
-    constexpr double a5 = -30.6647980661472;
-    constexpr double a6 = 2.50662827745924;
-
-    constexpr double b1 = -54.4760987982241;
-    constexpr double b2 = 161.585836858041;
-    constexpr double b3 = -155.698979859887;
-    constexpr double b4 = 66.8013118877197;
-    constexpr double b5 = -13.2806815528857;
-
-    constexpr double c1 = -7.78489400243029E-03;
-    constexpr double c2 = -0.322396458041136;
-    constexpr double c3 = -2.40075827716184;
-    constexpr double c4 = -2.54973253934373;
-    constexpr double c5 = 4.37466414146497;
-    constexpr double c6 = 2.93816398269878;
-
-    constexpr double d1 = 7.78469570904146E-03;
-    constexpr double d2 = 0.32246712907004;
-    constexpr double d3 = 2.445134137143;
-    constexpr double d4 = 3.75440866190742;
-
-    // Define break-points
-    constexpr double p_low = 0.02425;
-    constexpr double p_high = 1 - p_low;
-
-    // Define work variables
-
-    // If argument out of bounds, raise error
-    if (p <= 0 || p >= 1) throw;
-
-    if (p < p_low)
+    // Each worker gets its own copy of the fund return objects set up in generateAllScenarios
+    ScenarioWorkerContext ctx;
+
+    ctx.DiversifiedFund      = DiversifiedFund;
+    ctx.InternationalFund    = InternationalFund;
+    ctx.IntermediateRiskFund = IntermediateRiskFund;
+    ctx.AggressiveFund       = AggressiveFund;
+
+    ctx.MoneyFund    = MoneyFund;
+    ctx.IntGovtFund  = IntGovtFund;
+    ctx.LongCorpFund = LongCorpFund;
+
+    // The historical curves and their index are read-only once loaded, so every worker shares them
+    ctx.intScenario.setInterpolation(curveInterpolation, &HistData);
+
+    if (writeScenarioFiles && outputFormat == OutputFormat::BINARY)
+        ctx.binaryWriter.open(output_dir + SCENARIO_FILE_NAME);
+
+    return ctx;
+}
+
+
+void ScenarioGenerator::WriteScenario(ScenarioWorkerContext& ctx, const FundScenario& fundScenario, int scn_number, const string& output_dir)
+{
+    if (valuationPipeline)
+        valuationPipeline->submit(scn_number, fundScenario);
+
+    if (!writeScenarioFiles)
+        return;
+
+    if (outputFormat == OutputFormat::BINARY)
     {
-        // Rational approximation for lower region
-        double q = sqrt(-2 * log(p));
-        return (((((c1 * q + c2) * q + c3) * q + c4) * q + c5) * q + c6) / ((((d1 * q + d2) * q + d3) * q + d4) * q + 1);
+        ctx.binaryWriter.write(scn_number, fundScenario);
     }
-    else if (p <= p_high)
+    else
     {
-        // Rational approximation for lower region
-        double q = p - 0.5;
-        double r = q * q;
-        return (((((a1 * r + a2) * r + a3) * r + a4) * r + a5) * r + a6) * q / (((((b1 * r + b2) * r + b3) * r + b4) * r + b5) * r + 1);
+        scenarioToJson(fundScenario, scn_number, ctx.jsonBuffer);
+
+        if (singleFileWriter)
+        {
+            singleFileWriter->submit(scn_number, ctx.jsonBuffer);
+        }
+        else
+        {
+            string outfilename (output_dir + "scenario_" + std::to_string(scn_number) + ".json");
+
+            writeScenarioToFile(ctx.jsonBuffer, outfilename);
+        }
     }
-    else if (p < 1)
+}
+
+
+void ScenarioGenerator::GenerateSingleScenario(ScenarioWorkerContext& ctx, int scn_number, Frequency projFrequency, int ProjectionYears, Date startDate, bool generateForStochExclTest, bool useNaicMeanRevPoint, const ScenarioGeneratorParams& params, const CholeskyFactor& correlationFactor, const string& output_dir)
+{
+    ctx.SetEquityVolatilities(params.DiversifiedVol, params.InternationalVol, params.IntermediateVol, params.AggressiveVol);  // Resets the volatility for the equity fund scenarios that use stochastic volatility
+
+    auto generatePaths = [&](auto& rng)
     {
-        // Rational approximation for upper region
-        double q = sqrt(-2 * log(1 - p));
-        return -(((((c1 * q + c2) * q + c3) * q + c4) * q + c5) * q + c6) / ((((d1 * q + d2) * q + d3) * q + d4) * q + 1);
+        ctx.intScenario.Generate(scn_number, testShocks.get(), antitheticPairs, initialRateCurve,
+            ProjectionYears, params, rng);
+
+        ctx.fundScenario.Generate(scn_number, ctx.intScenario, testShocks.get(), antitheticPairs, ProjectionYears,
+                                  correlationFactor, rng, ctx.DiversifiedFund, ctx.InternationalFund, ctx.IntermediateRiskFund,
+                                  ctx.AggressiveFund, ctx.MoneyFund, ctx.IntGovtFund, ctx.LongCorpFund);
+    };
+
+    switch (randomGenerator)
+    {
+    case RandomGenerator::PHILOX: generatePaths(ctx.philoxRNG); break;
+    case RandomGenerator::SOBOL:  generatePaths(ctx.sobolRNG);  break;
+    default:                      generatePaths(ctx.m_RNG);     break;
     }
 
-    throw;
+    WriteScenario(ctx, ctx.fundScenario, scn_number, output_dir);
 }
 
 
-bool ScenarioGenerator::StartingCurveOK(Date startingDate, const map<double, double>& startingCurve, const map<Date, map<double, double>>& historicalData) const
+// Generates the interest rate paths and fund returns of up to IntScenarioBatch::Lanes scenarios
+// together, then writes each in turn
+void ScenarioGenerator::GenerateScenarioBatch(ScenarioWorkerContext& ctx, int first_scn_number, int count, int ProjectionYears, const ScenarioGeneratorParams& params, const CholeskyFactor& correlationFactor, const string& output_dir)
 {
-    Date histDate;
-    HistCurves histCurves;
-
+    ctx.SetEquityVolatilities(params.DiversifiedVol, params.InternationalVol, params.IntermediateVol, params.AggressiveVol);
 
-    auto StartingCurveOKbbb = true;
+    auto generatePaths = [&](auto& rng)
+    {
+        ctx.intBatch.Generate(first_scn_number, count, testShocks.get(), antitheticPairs, initialRateCurve, ProjectionYears, params, rng);
 
-    histCurves.Initialize(historicalData);
-    histDate = startingDate;
+        ctx.fundBatch.Generate(first_scn_number, count, testShocks.get(), antitheticPairs, ctx.intBatch, ProjectionYears,
+                               correlationFactor, rng, ctx.DiversifiedFund, ctx.InternationalFund, ctx.IntermediateRiskFund,
+                               ctx.AggressiveFund, ctx.MoneyFund, ctx.IntGovtFund, ctx.LongCorpFund);
+    };
 
-    // Check whether the starting date is OK
-    if (histDate < histCurves.getFirstDate() || histDate > histCurves.getLastDate())
-        return false;
-    else // Date is within historical curves period.
+    switch (randomGenerator)
     {
-        // Check whether the starting yield curve matches history.
-        bool mismatch = false;
+    case RandomGenerator::PHILOX: generatePaths(ctx.philoxRNG); break;
+    case RandomGenerator::SOBOL:  generatePaths(ctx.sobolRNG);  break;
+    default:                      generatePaths(ctx.m_RNG);     break;
+    }
+
+    for (auto lane = 0; lane < count; lane++)
+        WriteScenario(ctx, ctx.fundBatch.scenario(lane), first_scn_number + lane, output_dir);
+}
 
-        if (startingCurve != histCurves.getCurveByDate(histDate))
-            mismatch = true;
 
-        if (mismatch)
-            return false;
+void ScenarioGenerator::GenerateScenarioRange(ScenarioWorkerContext& ctx, int start_scn_number, int end_scn_number, Frequency projFrequency, int ProjectionYears, Date startDate, bool generateForStochExclTest, bool useNaicMeanRevPoint, const ScenarioGeneratorParams& params, const CholeskyFactor& correlationFactor, const string& output_dir)
+{
+    if (batchScenarios)
+    {
+        for (auto i = start_scn_number; i < end_scn_number; i += IntScenarioBatch::Lanes)
+        {
+            GenerateScenarioBatch(ctx, i, std::min(IntScenarioBatch::Lanes, end_scn_number - i), ProjectionYears, params, correlationFactor, output_dir);
+        }
 
-    }  // Date is within historical curves period'
+        return;
+    }
 
-    return true;
+    for (auto i = start_scn_number; i < end_scn_number; i++)
+    {
+        GenerateSingleScenario(ctx, i, projFrequency, ProjectionYears, startDate, generateForStochExclTest, useNaicMeanRevPoint, params, correlationFactor, output_dir);
+    }
 }
 
-
-void ScenarioGenerator::GenerateSingleScenario(int scn_number, Frequency projFrequency, int ProjectionYears, Date startDate, bool generateForStochExclTest, bool useNaicMeanRevPoint, ScenarioGeneratorParams params, const actlib::table<double>& CorrelationMatrix, const string& output_dir)
+void ScenarioGenerator::GenerateScenarioWorker(ScenarioScheduler& scheduler, WorkerStats& stats, Frequency projFrequency, int ProjectionYears, Date startDate, bool generateForStochExclTest, bool useNaicMeanRevPoint, const ScenarioGeneratorParams& params, const CholeskyFactor& correlationFactor, const string& output_dir)
 {
-    thread_local MersenneTwister m_RNG;               // Random Number Generator
+    int start_scn, end_scn;
 
-    SetEquityVolatilities(params.DiversifiedVol, params.InternationalVol, params.IntermediateVol, params.AggressiveVol);  // Resets the volatility for the equity fund scenarios that use stochastic volatility
+    // The context lives for the whole run on this thread and is reused for every scenario it generates
+    ScenarioWorkerContext ctx = makeWorkerContext(output_dir);
 
-    intScenario.Generate(scn_number, generateForStochExclTest, HistData.getCurveVecByDate(startDate),
-        ProjectionYears, params, m_RNG);
+    // Keep claiming chunks until the scheduler runs out of scenarios
+    while (scheduler.next(start_scn, end_scn))
+    {
+        auto chunkStart = std::chrono::steady_clock::now();
 
-    fundScenario.Generate(scn_number, intScenario, generateForStochExclTest, ProjectionYears,
-                          CorrelationMatrix, m_RNG, DiversifiedFund, InternationalFund, IntermediateRiskFund,
-                          AggressiveFund, MoneyFund, IntGovtFund, LongCorpFund);
+        GenerateScenarioRange(ctx, start_scn, end_scn, projFrequency, ProjectionYears, startDate, generateForStochExclTest, useNaicMeanRevPoint, params, correlationFactor, output_dir);
 
-    string outfilename (output_dir + "scenario_" + std::to_string(scn_number) + ".json");
+        auto chunkEnd = std::chrono::steady_clock::now();
 
-    writeScenarioToFile(scn_number, outfilename);
+        stats.scenarios += end_scn - start_scn;
+        stats.chunks++;
+        stats.busySec += std::chrono::duration<double>(chunkEnd - chunkStart).count();
+    }
 }
 
-void ScenarioGenerator::GenerateScenarioRange(int start_scn_number, int end_scn_number, Frequency projFrequency, int ProjectionYears, Date startDate, bool generateForStochExclTest, bool useNaicMeanRevPoint, ScenarioGeneratorParams params, const actlib::table<double>& CorrelationMatrix, const string& output_dir)
+void ScenarioGenerator::printUtilizationReport(const vector<WorkerStats>& stats, double elapsedSec) const
 {
-    for (auto i = start_scn_number; i < end_scn_number; i++)
+    std::cout << "Thread utilization:\n";
+    std::cout << std::setw(8) << "thread" << std::setw(12) << "scenarios" << std::setw(10) << "chunks" << std::setw(12) << "busy (s)" << std::setw(10) << "util %" << "\n";
+
+    for (size_t i = 0; i < stats.size(); i++)
     {
-        GenerateSingleScenario(i, projFrequency, ProjectionYears, startDate, generateForStochExclTest, useNaicMeanRevPoint, params, CorrelationMatrix, output_dir);
+        double utilization = elapsedSec > 0 ? 100. * stats[i].busySec / elapsedSec : 0.;
+
+        std::cout << std::setw(8) << i
+                  << std::setw(12) << stats[i].scenarios
+                  << std::setw(10) << stats[i].chunks
+                  << std::setw(12) << std::fixed << std::setprecision(3) << stats[i].busySec
+                  << std::setw(10) << std::setprecision(1) << utilization << "\n";
     }
+
+    std::cout << std::defaultfloat;
 }
 
 
-void ScenarioGenerator::generateAllScenarios(Frequency projFrequency, int ProjectionYears, int num_scenarios, Date startDate, bool generateForStochExclTest, bool useNaicMeanRevPoint, ScenarioGeneratorParams params, const actlib::table<double>& CorrelationMatrix, int num_threads, const string& output_dir)
+void ScenarioGenerator::generateAllScenarios(const ScenarioRunOptions& options, ScenarioGeneratorParams params, const actlib::table<double>& CorrelationMatrix)
 {
     // Used for file purposes - output fileNums
     actlib::vector<int> naYieldFileNums(YieldPoints + 9);  // last 9 are for fund returns
     actlib::vector<int> naRNG_FileNums(NumProcesses + 1);  // last 1 is for fund return shocks
 
     // nProjFrequency: 1=Annual, 2=S/A, 4=Quarterly, 12=Monthly (the default)
-    int nProjFrequency = periods_per_year(projFrequency);
+    int nProjFrequency = periods_per_year(options.frequency);
 
 
     // Update the mean reversion point based on the scenario start date
-    if (useNaicMeanRevPoint) MeanReversionPointUpdate(startDate, naicMeanReversionPoints);
+    if (options.useNaicMeanRevPoint) MeanReversionPointUpdate(options.startDate, naicMeanReversionPoints);
 
     // Save the start time for use when later determining total elapsed time.
     auto StartTime = std::chrono::system_clock::now();
 
 
-    // Initialize the historical yield curve data to be used when interpolating generated curves
     // Set up an array used for headings in output files
     double vOutputMaturities[] = { 0.25, 0.5, 1, 2, 3, 5, 7, 10, 20, 30 };
 
-    map<Date, map<double, double>> historicalData;
-
-    constexpr Date April1953 {.month = APRIL, .year = 1953};
+    // The historical yield curves give the starting curve and are used when interpolating generated curves
+    if (HistData.getNumCurves() == 0)
+        throw std::runtime_error("the historical curves must be loaded before generating scenarios");
 
-    load_historical_data(historicalData, April1953, 0.25, "C:\\Users\\scott\\source\\repos\\Scenario-Generator\\Historic-Curves\\0.25.csv");
-    load_historical_data(historicalData, April1953, 0.5,  "C:\\Users\\scott\\source\\repos\\Scenario-Generator\\Historic-Curves\\0.5.csv");
-    load_historical_data(historicalData, April1953, 1,    "C:\\Users\\scott\\source\\repos\\Scenario-Generator\\Historic-Curves\\1.csv");
-    load_historical_data(historicalData, April1953, 2,    "C:\\Users\\scott\\source\\repos\\Scenario-Generator\\Historic-Curves\\2.csv");
-    load_historical_data(historicalData, April1953, 3,    "C:\\Users\\scott\\source\\repos\\Scenario-Generator\\Historic-Curves\\3.csv");
-    load_historical_data(historicalData, April1953, 5,    "C:\\Users\\scott\\source\\repos\\Scenario-Generator\\Historic-Curves\\5.csv");
-    load_historical_data(historicalData, April1953, 7,    "C:\\Users\\scott\\source\\repos\\Scenario-Generator\\Historic-Curves\\7.csv");
-    load_historical_data(historicalData, April1953, 10,   "C:\\Users\\scott\\source\\repos\\Scenario-Generator\\Historic-Curves\\10.csv");
-    load_historical_data(historicalData, April1953, 20,   "C:\\Users\\scott\\source\\repos\\Scenario-Generator\\Historic-Curves\\20.csv");
-    load_historical_data(historicalData, April1953, 30,   "C:\\Users\\scott\\source\\repos\\Scenario-Generator\\Historic-Curves\\30.csv");
+    if (options.startDate < HistData.getFirstDate() || HistData.getLastDate() < options.startDate)
+        throw std::out_of_range("the start date is outside the historical curves");
 
-    HistData.Initialize(historicalData);
+    initialRateCurve = HistData.getCurveVecByDate(options.startDate);
 
     DiversifiedFund      = EquityFundReturn(params.diversified_params);
     InternationalFund    = EquityFundReturn(params.international_params);
@@ -183,68 +252,198 @@ void ScenarioGenerator::generateAllScenarios(Frequency projFrequency, int Projec
     IntGovtFund = FixedFundReturn(params.us_intermed_govt);
     LongCorpFund = FixedFundReturn(params.us_long_corporate);
 
-    if (num_threads == 1)
+    // The fund return correlations are fixed for the run, so they are checked and factored once here
+    // and every worker shares the factor read-only
+    const CholeskyFactor correlationFactor = [&]() {
+        try
+        {
+            return CholeskyFactor(CorrelationMatrix);
+        }
+        catch (const std::invalid_argument& e)
+        {
+            if (!options.repairCorrelations)
+                throw;
+
+            std::cout << e.what() << "\n";
+        }
+
+        actlib::table<double> repaired = NearestCorrelationMatrix(CorrelationMatrix);
+
+        double maxChange = 0;
+
+        for (auto i = 0; i < repaired.size(1); i++)
+            for (auto j = 0; j < repaired.size(2); j++)
+                maxChange = std::max(maxChange, std::abs(repaired(i, j) - CorrelationMatrix(i, j)));
+
+        std::cout << "Using the nearest positive definite correlation matrix instead, largest change " << maxChange << "\n";
+
+        return CholeskyFactor(repaired);
+    }();
+
+    // The binary file is created and sized here; each worker then opens its own handle to it
+    outputFormat = options.format;
+    randomGenerator = options.rng;
+    antitheticPairs = options.antithetic;
+    curveInterpolation = options.interpolation;
+
+    // IntScenarioBatch only interpolates with Nelson-Siegel
+    if (options.batch && options.interpolation != CurveInterpolation::NELSON_SIEGEL)
+        throw std::invalid_argument("batched scenario generation needs Nelson-Siegel interpolation");
+
+    batchScenarios = options.batch;
+
+    // The test shocks are worked out once for every worker rather than month by month in each scenario
+    if (options.generateForStochExclTest)
     {
-        for (auto i = 1; i <= num_scenarios; i++)
+        if (options.numScenarios < 1 || options.numScenarios > TestShockTable::NumScenarios)
+            throw std::invalid_argument("the stochastic exclusion test has " + std::to_string(TestShockTable::NumScenarios) + " scenarios");
+
+        testShocks = std::make_unique<TestShockTable>(options.projectionYears * 12);
+    }
+
+    if (writeScenarioFiles && outputFormat == OutputFormat::BINARY)
+        BinaryScenarioWriter::createFile(options.outputDir + SCENARIO_FILE_NAME, options.projectionYears * 12, options.numScenarios);
+
+    // The binary format is already a single file, so --single_file only changes how JSON output is written
+    if (writeScenarioFiles && outputFormat == OutputFormat::JSON && options.singleFile)
+    {
+        singleFileWriter = std::make_unique<SingleFileScenarioWriter>(options.outputDir + "scenarios.json", options.orderedSingleFile, 4 * options.numThreads);
+        singleFileWriter->start(1);
+    }
+
+    if (valuationParams)
+    {
+        valuationPipeline = std::make_unique<ValuationPipeline>(*valuationParams, options.outputDir, options.numScenarios, options.projectionYears * 12, 4 * options.numThreads);
+        valuationPipeline->start(1);
+    }
+
+    vector<WorkerStats> worker_stats(options.numThreads);
+
+    auto poolStartTime = std::chrono::steady_clock::now();
+
+    if (options.numThreads == 1)
+    {
+        ScenarioWorkerContext ctx = makeWorkerContext(options.outputDir);
+
+        // Each scenario, or each batch, counts as a chunk in the utilization report
+        auto generateRange = [&](int start_scn, int end_scn) {
+            auto chunkStart = std::chrono::steady_clock::now();
+
+            GenerateScenarioRange(ctx, start_scn, end_scn, options.frequency, options.projectionYears, options.startDate, options.generateForStochExclTest, options.useNaicMeanRevPoint, params, correlationFactor, options.outputDir);
+
+            worker_stats[0].scenarios += end_scn - start_scn;
+            worker_stats[0].chunks++;
+            worker_stats[0].busySec += std::chrono::duration<double>(std::chrono::steady_clock::now() - chunkStart).count();
+        };
+
+        for (auto i = 1; i <= options.numScenarios; i++)
         {
             std::cout << "Generating scenario " << i << "\n";
-            GenerateSingleScenario(i, projFrequency, ProjectionYears, startDate, generateForStochExclTest, useNaicMeanRevPoint, params, CorrelationMatrix, output_dir);
+
+            if (batchScenarios)
+            {
+                // Once per batch; the progress lines for the rest of the batch follow
+                if ((i - 1) % IntScenarioBatch::Lanes == 0)
+                    generateRange(i, std::min(i + IntScenarioBatch::Lanes, options.numScenarios + 1));
+
+                continue;
+            }
+
+            generateRange(i, i + 1);
         }
     }
     else
     {
-        vector<std::thread> thread_pool(num_threads);
+        vector<std::thread> thread_pool(options.numThreads);
+        vector<std::exception_ptr> worker_errors(options.numThreads);  // rethrown here once every worker has stopped
 
-        // Loop to generate the scenarios and write results to output files
-        int num_scenarios_per_thread = num_scenarios / num_threads;
-        for (auto i = 0; i < num_threads; i ++)
-        {
-            int start_scn = i * num_scenarios_per_thread + 1;
-            int end_scn   = std::min(start_scn + num_scenarios_per_thread, num_scenarios + 1);
-        
-            if (i == num_threads - 1)
-                end_scn += num_scenarios % num_threads;
+        // Scenarios are handed out in chunks as threads become free rather than in fixed blocks per thread
+        ScenarioScheduler scheduler(1, options.numScenarios, options.chunkSize);
 
-            thread_pool[i] = std::move(std::thread(&ScenarioGenerator::GenerateScenarioRange, this, start_scn, end_scn, projFrequency, ProjectionYears, startDate, generateForStochExclTest, useNaicMeanRevPoint, params, CorrelationMatrix, output_dir));
+        for (auto i = 0; i < options.numThreads; i++)
+        {
+            thread_pool[i] = std::thread([&, i]() {
+                try
+                {
+                    GenerateScenarioWorker(scheduler, worker_stats[i], options.frequency, options.projectionYears, options.startDate, options.generateForStochExclTest, options.useNaicMeanRevPoint, params, correlationFactor, options.outputDir);
+                }
+                catch (...)
+                {
+                    worker_errors[i] = std::current_exception();
+                }
+            });
         }
 
-        for (auto j = 0; j < num_threads; j++)
+        for (auto j = 0; j < options.numThreads; j++)
         {
             thread_pool[j].join();
         }
+
+        for (const auto& error : worker_errors)
+        {
+            if (error)
+                std::rethrow_exception(error);
+        }
     }
 
+    auto poolEndTime = std::chrono::steady_clock::now();
+
+    printUtilizationReport(worker_stats, std::chrono::duration<double>(poolEndTime - poolStartTime).count());
+
+    if (singleFileWriter)
+    {
+        singleFileWriter->finish();
+        singleFileWriter.reset();
+    }
+
+    if (valuationPipeline)
+    {
+        valuationPipeline->finish();
+        valuationPipeline.reset();
+    }
+
+    testShocks.reset();
+
     auto dEndTime = std::chrono::system_clock::now();
 
     std::cout << "Processing time = " << std::chrono::duration_cast<std::chrono::seconds>(dEndTime - StartTime).count() << " seconds" << std::endl;
 }
 
 
-string ScenarioGenerator::scenarioToJsonString(int scenarioNumber) const
+void ScenarioGenerator::scenarioToJson(const FundScenario& fundScenario, int scenarioNumber, JsonBuffer& out) const
 {
-    string s;
+    out.clear();
 
-    s += "{";
+    out.put('{');
 
-    s += "\"equities\":" + fundScenario.serializeToJson() + /*"," +*/ "\n";
-    //s += "\"yield_curves\":" + intScenario.serializeToJson() + "\n";
+    out.put("\"equities\":");
+
+    try
+    {
+        fundScenario.serializeToJson(out);
+    }
+    catch (const std::domain_error& e)
+    {
+        throw std::domain_error("scenario " + std::to_string(scenarioNumber) + ": " + e.what());
+    }
 
-    s += "}";
+    out.put('\n');
+    //out.put("\"yield_curves\":"); intScenario.serializeToJson(out);
 
-    return s;
+    out.put('}');
 }
 
-void ScenarioGenerator::writeScenarioToFile(int scenarioNumber, string filename) const
+void ScenarioGenerator::writeScenarioToFile(const JsonBuffer& json, const string& filename) const
 {
-    ofstream file (filename, std::ios::out | std::ios::trunc);
+    ofstream file (filename, std::ios::out | std::ios::trunc | std::ios::binary);
 
-    file << scenarioToJsonString(scenarioNumber);
+    file.write(json.data(), json.size());
 
     file.close();
 }
 
 
-void ScenarioGenerator::SetEquityVolatilities(double DiversifiedVol, double InternationalVol, double IntermediateVol, double AggressiveVol)
+void ScenarioWorkerContext::SetEquityVolatilities(double DiversifiedVol, double InternationalVol, double IntermediateVol, double AggressiveVol)
 {
     DiversifiedFund.currentVol      = DiversifiedVol;
     InternationalFund.currentVol    = InternationalVol;
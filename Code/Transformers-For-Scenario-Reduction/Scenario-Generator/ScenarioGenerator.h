@@ -1,26 +1,34 @@
 #pragma once
 
 //#include <map>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "Vector.h"
 
+#include "BinaryScenarioWriter.h"
 #include "C3RNG.h"
+#include "Cholesky.h"
 #include "HistCurves.h"
 #include "EquityFundReturn.h"
 #include "FixedFundReturn.h"
 #include "IntScenario.h"
+#include "IntScenarioBatch.h"
 #include "FundScenario.h"
+#include "FundScenarioBatch.h"
+#include "JsonBuffer.h"
 #include "ScenarioGeneratorParams.hpp"
+#include "ScenarioScheduler.h"
+#include "SingleFileScenarioWriter.h"
+#include "ValuationPipeline.h"
 
 
 using std::map;
 using std::string;
 using std::vector;
 
-double InverseNormal(double p);
-
 enum class Frequency
 {
     ANNUAL,
@@ -30,6 +38,21 @@ enum class Frequency
 };
 
 
+enum class OutputFormat
+{
+    JSON,     // one scenario_N.json file per scenario
+    BINARY    // every scenario in a single binary file (see ScenarioFile.h)
+};
+
+
+enum class RandomGenerator
+{
+    MERSENNE_TWISTER,  // std::mt19937_64 reseeded for each scenario; reproduces earlier output
+    PHILOX,            // counter-based Philox4x32-10 keyed by scenario and stream
+    SOBOL              // quasi-Monte Carlo: scrambled Sobol points with a Brownian bridge (see SobolGenerator.h)
+};
+
+
 inline int periods_per_year(Frequency f)
 {
     switch (f)
@@ -43,10 +66,76 @@ inline int periods_per_year(Frequency f)
 }
 
 
+// How generateAllScenarios() runs: what to generate, how, and where the output goes
+struct ScenarioRunOptions
+{
+    Frequency frequency = Frequency::MONTHLY;
+    int projectionYears = 0;
+    int numScenarios = 0;
+    Date startDate {};
+
+    bool generateForStochExclTest = false;  // the 16 deterministic scenarios of the stochastic exclusion test
+    bool useNaicMeanRevPoint = false;
+
+    int numThreads = 1;
+    int chunkSize = 8;  // scenarios a thread claims at a time
+
+    OutputFormat format = OutputFormat::JSON;
+    RandomGenerator rng = RandomGenerator::MERSENNE_TWISTER;
+    bool antithetic = false;
+    bool repairCorrelations = false;  // use the nearest positive definite correlation matrix if need be
+    CurveInterpolation interpolation = CurveInterpolation::NELSON_SIEGEL;
+    bool batch = false;               // generate IntScenarioBatch::Lanes scenarios at a time
+
+    bool singleFile = false;          // JSON output in one file instead of one file per scenario
+    bool orderedSingleFile = true;    // with singleFile, write the scenarios in scenario order
+
+    string outputDir;
+};
+
+
+/**
+ * The state a worker thread writes to while generating a scenario.  Each thread
+ * owns one context for the whole run, so threads never share scenario buffers
+ * and each thread reuses its own objects from one scenario to the next.
+ */
+
+struct ScenarioWorkerContext
+{
+    IntScenario intScenario;
+    FundScenario fundScenario;
+
+    // Used instead of intScenario and fundScenario when scenarios are generated in batches
+    IntScenarioBatch intBatch;
+    FundScenarioBatch fundBatch;
+
+    EquityFundReturn DiversifiedFund;
+    EquityFundReturn InternationalFund;
+    EquityFundReturn IntermediateRiskFund;
+    EquityFundReturn AggressiveFund;
+
+    FixedFundReturn MoneyFund;
+    FixedFundReturn IntGovtFund;
+    FixedFundReturn LongCorpFund;
+
+    MersenneTwister m_RNG;  // Random Number Generator, reseeded for each scenario
+    Philox philoxRNG;       // used instead of m_RNG for RandomGenerator::PHILOX
+    SobolGenerator sobolRNG;  // used instead of m_RNG for RandomGenerator::SOBOL
+
+    BinaryScenarioWriter binaryWriter;  // only opened for OutputFormat::BINARY
+
+    JsonBuffer jsonBuffer;  // reused for every scenario this thread serializes
+
+    void SetEquityVolatilities(double DiversifiedVol, double InternationalVol, double IntermediateVol, double AggressiveVol);
+};
+
+
 class ScenarioGenerator
 {
     HistCurves HistData;  // Object containing all historical yield curves
 
+    actlib::vector<double> initialRateCurve;  // Historical curve at the start date, looked up once per run
+
     ScenarioGeneratorParams params;
 
     // Rounding level
@@ -71,28 +160,56 @@ class ScenarioGenerator
     // Number of stochastic processes in the interest rate generator
     static constexpr int NumProcesses = 3;
 
-    IntScenario intScenario;
-    FundScenario fundScenario;
-
     int scenarioCount;
 
-    bool StartingCurveOK(Date startingDate, const map<double, double>& startingCurve, const map<Date, map<double, double>>& historicalData) const;
+    OutputFormat outputFormat = OutputFormat::JSON;
+    RandomGenerator randomGenerator = RandomGenerator::MERSENNE_TWISTER;
+    CurveInterpolation curveInterpolation = CurveInterpolation::NELSON_SIEGEL;
+    bool antitheticPairs = false;  // scenarios 2k-1 and 2k are generated from the same draws with opposite signs
+    bool batchScenarios = false;   // IntScenarioBatch and FundScenarioBatch generate IntScenarioBatch::Lanes scenarios at a time
+
+    // Set for the duration of a run that generates the stochastic exclusion test scenarios; shared read-only by the workers
+    std::unique_ptr<TestShockTable> testShocks;
+
+    // Set for the duration of a run when JSON output goes to a single file
+    std::unique_ptr<SingleFileScenarioWriter> singleFileWriter;
+
+    // Set by valueScenarios(); the pipeline exists for the duration of a run
+    std::optional<ValuationParams> valuationParams;
+    bool writeScenarioFiles = true;
+    std::unique_ptr<ValuationPipeline> valuationPipeline;
 
     bool isFilenameSuffixValid(string filenameSuffix) const;
 
     void MeanReversionPointUpdate(Date startDate, map<Date, double> NaicMeanRevPoints);
 
-    void SetEquityVolatilities(double DiversifiedVol, double InternationalVol, double IntermediateVol, double AggressiveVol);
+    ScenarioWorkerContext makeWorkerContext(const string& output_dir) const;
+
+    void WriteScenario(ScenarioWorkerContext& ctx, const FundScenario& fundScenario, int scn_number, const string& output_dir);
+    void GenerateScenarioBatch(ScenarioWorkerContext& ctx, int first_scn_number, int count, int ProjectionYears, const ScenarioGeneratorParams& params, const CholeskyFactor& correlationFactor, const string& output_dir);
+    void GenerateSingleScenario(ScenarioWorkerContext& ctx, int scn_number, Frequency projFrequency, int ProjectionYears, Date startDate, bool generateForStochExclTest, bool useNaicMeanRevPoint, const ScenarioGeneratorParams& params, const CholeskyFactor& correlationFactor, const string& output_dir);
+    void GenerateScenarioRange(ScenarioWorkerContext& ctx, int start_scn_number, int end_scn_number, Frequency projFrequency, int ProjectionYears, Date startDate, bool generateForStochExclTest, bool useNaicMeanRevPoint, const ScenarioGeneratorParams& params, const CholeskyFactor& correlationFactor, const string& output_dir);
+    void GenerateScenarioWorker(ScenarioScheduler& scheduler, WorkerStats& stats, Frequency projFrequency, int ProjectionYears, Date startDate, bool generateForStochExclTest, bool useNaicMeanRevPoint, const ScenarioGeneratorParams& params, const CholeskyFactor& correlationFactor, const string& output_dir);
 
-    void GenerateSingleScenario(int scn_number, Frequency projFrequency, int ProjectionYears, Date startDate, bool generateForStochExclTest, bool useNaicMeanRevPoint, ScenarioGeneratorParams params, const actlib::table<double>& CorrelationMatrix, const string& output_dir);
-    void GenerateScenarioRange(int start_scn_number, int end_scn_number, Frequency projFrequency, int ProjectionYears, Date startDate, bool generateForStochExclTest, bool useNaicMeanRevPoint, ScenarioGeneratorParams params, const actlib::table<double>& CorrelationMatrix, const string& output_dir);
+    void printUtilizationReport(const vector<WorkerStats>& stats, double elapsedSec) const;
 
-    string scenarioToJsonString(int scenarioNumber) const;
+    void scenarioToJson(const FundScenario& fundScenario, int scenarioNumber, JsonBuffer& out) const;
 
 public:
 
-    void generateAllScenarios(Frequency projFrequency, int ProjectionYears, int num_scenarios, Date startDate, bool generateForStochExclTest, bool useNaicMeanRevPoint, ScenarioGeneratorParams params, const actlib::table<double>& CorrelationMatrix, int num_threads, const string& output_dir);
+    // Loads the historical yield curves from historyFile, a consolidated curve file, or if that is
+    // empty from the per-maturity files in historyDir.  Must be called before generateAllScenarios().
+    void loadHistoricalCurves(const string& historyDir, const string& historyFile);
+
+    // Writes the loaded historical curves to one consolidated file (binary if the name ends in .bin)
+    void saveHistoricalCurves(const string& filename) const;
+
+    // Values the scenarios with the GMIB model as generateAllScenarios() generates them, writing
+    // result.json to its output directory.  The scenario files are only written as well if writeFiles is set.
+    void valueScenarios(const ValuationParams& params, bool writeFiles);
+
+    void generateAllScenarios(const ScenarioRunOptions& options, ScenarioGeneratorParams params, const actlib::table<double>& CorrelationMatrix);
 
-    void writeScenarioToFile(int scenarioNumber, string filename) const;
+    void writeScenarioToFile(const JsonBuffer& json, const string& filename) const;
 };
 
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+
+/**
+ * This class hands out scenario numbers to the worker threads in small chunks.
+ * Each worker asks for its next chunk when it finishes the previous one, so a
+ * thread that hits a slow disk write or a long projection no longer holds up
+ * a fixed block of scenarios while the other threads sit idle.
+ *
+ * The chunk size trades scheduling overhead against load balance: a chunk of 1
+ * gives the best balance, larger chunks reduce contention on the shared counter.
+ */
+
+class ScenarioScheduler
+{
+    std::atomic<int> nextScenario;
+    int lastScenario;
+    int chunkSize;
+
+public:
+
+    ScenarioScheduler(int firstScenario, int lastScenario, int chunkSize) :
+        nextScenario(firstScenario),
+        lastScenario(lastScenario),
+        chunkSize(std::max(1, chunkSize))
+    {
+
+    }
+
+    // Claims the next chunk of scenarios [startScn, endScn).  Returns false once all scenarios are handed out.
+    bool next(int& startScn, int& endScn)
+    {
+        int start = nextScenario.fetch_add(chunkSize, std::memory_order_relaxed);
+
+        if (start > lastScenario)
+            return false;
+
+        startScn = start;
+        endScn   = std::min(start + chunkSize, lastScenario + 1);
+
+        return true;
+    }
+};
+
+
+/**
+ * Per-thread counters used for the utilization report printed at the end of a run.
+ */
+
+struct WorkerStats
+{
+    int scenarios  = 0;  // number of scenarios generated by this worker
+    int chunks     = 0;  // number of chunks claimed from the scheduler
+    double busySec = 0;  // time spent generating and writing scenarios
+};
@@ -0,0 +1,170 @@
+#include "SingleFileScenarioWriter.h"
+
+#include <stdexcept>
+
+
+SingleFileScenarioWriter::SingleFileScenarioWriter(const string& filename, bool ordered, size_t queueCapacity) :
+    filename(filename),
+    ordered(ordered),
+    queue(queueCapacity)
+{
+
+}
+
+
+SingleFileScenarioWriter::~SingleFileScenarioWriter()
+{
+    if (writerThread.joinable())
+    {
+        queue.close();
+        writerThread.join();
+    }
+}
+
+
+void SingleFileScenarioWriter::start(int firstScenario)
+{
+    file.open(filename, std::ios::out | std::ios::trunc | std::ios::binary);
+
+    if (!file)
+        throw std::runtime_error("unable to create output file " + filename);
+
+    writerThread = std::thread(&SingleFileScenarioWriter::run, this, firstScenario);
+}
+
+
+void SingleFileScenarioWriter::submit(int scenarioNumber, JsonBuffer& json)
+{
+    Record record{ .scenarioNumber = scenarioNumber, .json = takeBuffer() };
+
+    std::swap(record.json, json);
+
+    if (queue.push(std::move(record)))
+        return;
+
+    // The queue is only closed early by a failed writer, which sets writerError before closing it
+    if (writerError)
+        std::rethrow_exception(writerError);
+
+    throw std::logic_error("scenario " + std::to_string(scenarioNumber) + " was submitted after " + filename + " was finished");
+}
+
+
+JsonBuffer SingleFileScenarioWriter::takeBuffer()
+{
+    std::lock_guard lock(spareMutex);
+
+    if (spareBuffers.empty())
+        return JsonBuffer();  // grows to fit when the caller serializes into it
+
+    JsonBuffer buffer = std::move(spareBuffers.back());
+    spareBuffers.pop_back();
+
+    return buffer;
+}
+
+
+void SingleFileScenarioWriter::recycle(JsonBuffer&& buffer)
+{
+    buffer.clear();
+
+    std::lock_guard lock(spareMutex);
+    spareBuffers.push_back(std::move(buffer));
+}
+
+
+void SingleFileScenarioWriter::finish()
+{
+    queue.close();
+
+    if (writerThread.joinable())
+        writerThread.join();
+
+    if (writerError)
+        std::rethrow_exception(writerError);
+
+    file.close();
+
+    if (!file)
+        throw std::runtime_error("unable to write output file " + filename);
+
+    writeIndex();
+}
+
+
+void SingleFileScenarioWriter::run(int firstScenario)
+{
+    try
+    {
+        writeRecords(firstScenario);
+    }
+    catch (...)
+    {
+        writerError = std::current_exception();
+
+        // Wakes any worker blocked on a full queue; its submit() then reports the error
+        queue.close();
+    }
+}
+
+
+void SingleFileScenarioWriter::writeRecords(int firstScenario)
+{
+    // Scenarios that arrived ahead of the next one due in ordered mode
+    std::map<int, JsonBuffer> pending;
+    int nextScenario = firstScenario;
+
+    while (auto record = queue.pop())
+    {
+        if (!ordered)
+        {
+            append(record->scenarioNumber, record->json);
+            recycle(std::move(record->json));
+            continue;
+        }
+
+        pending.emplace(record->scenarioNumber, std::move(record->json));
+
+        while (!pending.empty() && pending.begin()->first == nextScenario)
+        {
+            append(nextScenario, pending.begin()->second);
+            recycle(std::move(pending.begin()->second));
+            pending.erase(pending.begin());
+            nextScenario++;
+        }
+    }
+
+    // Only reached with gaps if a worker stopped early; write what is left rather than drop it
+    for (auto& [scenarioNumber, json] : pending)
+        append(scenarioNumber, json);
+}
+
+
+void SingleFileScenarioWriter::append(int scenarioNumber, const JsonBuffer& json)
+{
+    file.write(json.data(), json.size());
+    file.put('\n');
+
+    if (!file)
+        throw std::runtime_error("unable to write scenario " + std::to_string(scenarioNumber) + " to " + filename);
+
+    index.push_back(IndexEntry{ .scenarioNumber = scenarioNumber, .offset = bytesWritten, .length = json.size() });
+
+    bytesWritten += json.size() + 1;
+}
+
+
+void SingleFileScenarioWriter::writeIndex() const
+{
+    std::ofstream indexFile(filename + ".idx", std::ios::out | std::ios::trunc);
+
+    indexFile << "scenario_number,offset,length\n";
+
+    for (const auto& entry : index)
+        indexFile << entry.scenarioNumber << "," << entry.offset << "," << entry.length << "\n";
+
+    indexFile.close();
+
+    if (!indexFile)
+        throw std::runtime_error("unable to write index file " + filename + ".idx");
+}
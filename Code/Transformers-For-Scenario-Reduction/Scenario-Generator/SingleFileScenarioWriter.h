@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BoundedQueue.h"
+
+#include "JsonBuffer.h"
+
+using std::string;
+
+/**
+ * This class writes every scenario into one output file from a dedicated writer thread.
+ *
+ * The worker threads submit each finished scenario as a serialized JsonBuffer through a bounded
+ * queue, and the writer thread appends them to the output file.  Alongside the output file it
+ * writes an index with the scenario number, byte offset and length of every record.
+ *
+ * A submitted buffer is swapped for an empty one that has already been written, so the text is
+ * never copied and, once as many buffers exist as scenarios in flight, nothing is allocated.
+ *
+ * In ordered mode the writer holds back scenarios that finish early until all earlier scenarios
+ * have been written, so the records appear in scenario order.  Otherwise records are written as
+ * they arrive and the index is the only way to find a given scenario.
+ */
+
+class SingleFileScenarioWriter
+{
+    struct Record
+    {
+        int scenarioNumber;
+        JsonBuffer json;
+    };
+
+    struct IndexEntry
+    {
+        int scenarioNumber;
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    string filename;
+    bool ordered;
+
+    actlib::bounded_queue<Record> queue;
+    std::thread writerThread;
+
+    std::ofstream file;
+    uint64_t bytesWritten = 0;
+    std::vector<IndexEntry> index;
+
+    // Set by the writer thread if it fails; the queue is then closed so submit() fails too
+    std::exception_ptr writerError;
+
+    std::mutex spareMutex;
+    std::vector<JsonBuffer> spareBuffers;  // buffers already written, handed back to the workers by submit()
+
+    JsonBuffer takeBuffer();
+    void recycle(JsonBuffer&& buffer);
+
+    void run(int firstScenario);
+    void writeRecords(int firstScenario);
+    void append(int scenarioNumber, const JsonBuffer& json);
+    void writeIndex() const;
+
+public:
+
+    SingleFileScenarioWriter(const string& filename, bool ordered, size_t queueCapacity);
+    ~SingleFileScenarioWriter();
+
+    void start(int firstScenario);
+
+    // Called from the worker threads; blocks while the queue is full.  json is swapped for an empty
+    // buffer to serialize the next scenario into.  Throws if the scenario cannot be written, because
+    // the writer has failed or finish() has already been called.
+    void submit(int scenarioNumber, JsonBuffer& json);
+
+    // Waits for every submitted scenario to be written, then writes the index file.  Throws if
+    // the writer failed.
+    void finish();
+};
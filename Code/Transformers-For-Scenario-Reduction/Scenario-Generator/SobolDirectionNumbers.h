@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Initial direction numbers for Sobol sequences from S. Joe and F. Y. Kuo, "Constructing
+ * Sobol sequences with better two-dimensional projections", SIAM J. Sci. Comput. 30 (2008),
+ * file new-joe-kuo-6.21201.  They were chosen so that the two-dimensional projections of the
+ * sequence are well distributed.
+ *
+ * Each row gives dimension d, the degree s of its primitive polynomial, the polynomial's
+ * inner coefficients a (a_1 in the top bit), and the odd initial values m_1 ... m_s.
+ * Dimension 1 is the van der Corput sequence and has no row.
+ */
+
+struct SobolInitialNumbers
+{
+    uint16_t dimension;
+    uint16_t degree;
+    uint16_t a;
+    uint16_t m[13];
+};
+
+// Enough dimensions for SobolGenerator::Dimensions
+constexpr int JoeKuoDimensions = 896;
+
+extern const SobolInitialNumbers JoeKuoInitialNumbers[JoeKuoDimensions - 1];
@@ -0,0 +1,249 @@
+#include "SobolGenerator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+#include "InverseNormal.h"
+#include "SobolDirectionNumbers.h"
+
+
+namespace
+{
+    constexpr int Bits = 32;
+    constexpr uint64_t ScrambleSeed = 20240601;  // fixed so that every run uses the same scramble
+
+    static_assert(SobolGenerator::Dimensions <= JoeKuoDimensions);
+
+
+    struct SobolTable
+    {
+        std::vector<uint32_t> direction;  // Bits scrambled direction numbers per dimension
+        std::vector<uint32_t> shift;      // digital shift per dimension
+    };
+
+
+    // Applies a random lower-triangular binary matrix with unit diagonal to every direction number of a dimension
+    void linearScramble(uint32_t* v, std::mt19937_64& gen)
+    {
+        uint32_t rows[Bits];
+
+        for (int digit = 0; digit < Bits; digit++)
+        {
+            uint32_t own   = uint32_t(1) << (Bits - 1 - digit);
+            uint32_t above = digit == 0 ? 0 : ~uint32_t(0) << (Bits - digit);
+
+            rows[digit] = own | (uint32_t(gen()) & above);
+        }
+
+        for (int k = 0; k < Bits; k++)
+        {
+            uint32_t scrambled = 0;
+
+            for (int digit = 0; digit < Bits; digit++)
+            {
+                uint32_t parity = std::popcount(rows[digit] & v[k]) & 1;
+                scrambled |= parity << (Bits - 1 - digit);
+            }
+
+            v[k] = scrambled;
+        }
+    }
+
+
+    SobolTable buildTable()
+    {
+        SobolTable table;
+        table.direction.resize(size_t(SobolGenerator::Dimensions) * Bits);
+        table.shift.resize(SobolGenerator::Dimensions);
+
+        // The first dimension is the van der Corput sequence
+        for (int k = 1; k <= Bits; k++)
+            table.direction[k - 1] = uint32_t(1) << (Bits - k);
+
+        for (int dim = 1; dim < SobolGenerator::Dimensions; dim++)
+        {
+            const SobolInitialNumbers& initial = JoeKuoInitialNumbers[dim - 1];
+            int degree = initial.degree;
+            uint32_t m[Bits + 1];
+
+            for (int k = 1; k <= degree; k++)
+                m[k] = initial.m[k - 1];
+
+            // m_k = 2 a_1 m_(k-1) ^ 4 a_2 m_(k-2) ^ ... ^ 2^s m_(k-s) ^ m_(k-s)
+            for (int k = degree + 1; k <= Bits; k++)
+            {
+                m[k] = m[k - degree] ^ (m[k - degree] << degree);
+
+                for (int i = 1; i < degree; i++)
+                {
+                    if (initial.a & (1u << (degree - 1 - i)))
+                        m[k] ^= m[k - i] << i;
+                }
+            }
+
+            for (int k = 1; k <= Bits; k++)
+                table.direction[size_t(dim) * Bits + k - 1] = m[k] << (Bits - k);
+        }
+
+        std::mt19937_64 gen(ScrambleSeed);
+
+        for (int dim = 0; dim < SobolGenerator::Dimensions; dim++)
+        {
+            linearScramble(&table.direction[size_t(dim) * Bits], gen);
+            table.shift[dim] = uint32_t(gen());
+        }
+
+        return table;
+    }
+
+
+    const SobolTable& sobolTable()
+    {
+        static const SobolTable table = buildTable();
+        return table;
+    }
+}
+
+
+double SobolGenerator::sobolUniform(int dim) const
+{
+    const SobolTable& table = sobolTable();
+    const uint32_t* v = &table.direction[size_t(dim) * Bits];
+
+    uint32_t x = table.shift[dim];
+
+    for (uint32_t index = pointIndex, k = 0; index != 0; index >>= 1, k++)
+    {
+        if (index & 1)
+            x ^= v[k];
+    }
+
+    // Centre of the 2^-32 cell, so the result is never 0 or 1
+    return (double(x) + 0.5) * 0x1.0p-32;
+}
+
+
+void SobolGenerator::setupBridge(int numSteps)
+{
+    // Brownian bridge construction order for times 1, 2, ..., numSteps
+    // (after P. Jaeckel, "Monte Carlo Methods in Finance", section 10.8)
+    bridgeSteps = numSteps;
+
+    bridgeIndex.assign(numSteps, 0);
+    leftIndex.assign(numSteps, 0);
+    rightIndex.assign(numSteps, 0);
+    leftWeight.assign(numSteps, 0.);
+    rightWeight.assign(numSteps, 0.);
+    stdDev.assign(numSteps, 0.);
+
+    z.resize(numSteps);
+    path.resize(numSteps);
+
+    auto t = [](int i) { return double(i + 1); };
+
+    std::vector<int> populated(numSteps, 0);  // nonzero once a time point has been placed on the path
+
+    populated[numSteps - 1] = 1;
+    bridgeIndex[0] = numSteps - 1;
+    stdDev[0] = sqrt(t(numSteps - 1));
+
+    for (int i = 1, j = 0; i < numSteps; i++)
+    {
+        while (populated[j])
+            j++;
+
+        int k = j;
+
+        while (!populated[k])
+            k++;
+
+        int l = j + ((k - 1 - j) >> 1);
+
+        populated[l] = i;
+        bridgeIndex[i] = l;
+        leftIndex[i] = j;
+        rightIndex[i] = k;
+
+        if (j != 0)
+        {
+            leftWeight[i]  = (t(k) - t(l)) / (t(k) - t(j - 1));
+            rightWeight[i] = (t(l) - t(j - 1)) / (t(k) - t(j - 1));
+            stdDev[i]      = sqrt((t(l) - t(j - 1)) * (t(k) - t(l)) / (t(k) - t(j - 1)));
+        }
+        else
+        {
+            leftWeight[i]  = 0;
+            rightWeight[i] = t(l) / t(k);
+            stdDev[i]      = sqrt(t(l) * (t(k) - t(l)) / t(k));
+        }
+
+        j = k + 1;
+
+        if (j >= numSteps)
+            j = 0;
+    }
+}
+
+
+void SobolGenerator::Seed(int scenNumber, RandomStream newStream)
+{
+    pointIndex = uint32_t(scenNumber - 1);
+    stream = newStream;
+
+    padding.Seed(scenNumber, newStream);
+}
+
+
+void SobolGenerator::FillNormals(std::span<double> out, int numProcesses)
+{
+    int firstProcess = stream == RandomStream::InterestRates ? 0 : RateProcesses;
+    int streamProcesses = stream == RandomStream::InterestRates ? RateProcesses : FundProcesses;
+
+    if (numProcesses > streamProcesses || out.size() % numProcesses != 0)
+        throw std::invalid_argument("SobolGenerator: unexpected number of processes for the stream");
+
+    int numMonths = int(out.size() / numProcesses);
+
+    if (numMonths == 0)
+        return;
+
+    if (numMonths != bridgeSteps)
+        setupBridge(numMonths);
+
+    int sobolLevels = std::min(BridgeLevelsFromSobol, numMonths);
+
+    for (int p = 0; p < numProcesses; p++)
+    {
+        // Uniforms in bridge order: the coarse levels from the Sobol point, the rest pseudo-random
+        for (int level = 0; level < sobolLevels; level++)
+            z[level] = sobolUniform(level * TotalProcesses + firstProcess + p);
+
+        padding.Seek(uint64_t(p) * numMonths + sobolLevels);
+        padding.Fill(std::span<double>(z).subspan(sobolLevels));
+
+        InverseNormal(z, z);
+
+        // Build the Brownian path, then hand out its monthly increments
+        path[numMonths - 1] = stdDev[0] * z[0];
+
+        for (int i = 1; i < numMonths; i++)
+        {
+            int j = leftIndex[i];
+            int k = rightIndex[i];
+            int l = bridgeIndex[i];
+
+            if (j != 0)
+                path[l] = leftWeight[i] * path[j - 1] + rightWeight[i] * path[k] + stdDev[i] * z[i];
+            else
+                path[l] = rightWeight[i] * path[k] + stdDev[i] * z[i];
+        }
+
+        out[p] = path[0];
+
+        for (int month = 1; month < numMonths; month++)
+            out[size_t(month) * numProcesses + p] = path[month] - path[month - 1];
+    }
+}
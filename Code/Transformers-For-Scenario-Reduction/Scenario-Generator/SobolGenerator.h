@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "C3RNG.h"
+
+/**
+ * Quasi-Monte Carlo generator: scenario n takes its shocks from point n of a
+ * scrambled Sobol sequence.
+ *
+ * The monthly shocks of each process are treated as the increments of a Brownian
+ * motion and the path is built with a Brownian bridge: the first normal fixes the
+ * end of the path, the next the middle, and so on.  The first bridge points, which
+ * decide most of the shape of a path, come from the Sobol coordinates.  Later bridge
+ * points only fill in detail and come from a Philox stream for the same scenario.
+ * Sobol dimensions are assigned level by level across all 14 processes, so the most
+ * important coordinate of every process uses the best-distributed dimensions.
+ *
+ * The direction numbers are those of Joe and Kuo (SobolDirectionNumbers.h).  They
+ * are scrambled with a random linear (Matousek) scramble and a digital shift drawn
+ * from a fixed seed, so every run gives the same scenarios.
+ *
+ * Only FillNormals() is supported.  The bridge works on normals, so the
+ * generator has no uniform GetNext().
+ */
+
+class SobolGenerator
+{
+public:
+
+    static constexpr int RateProcesses = 3;   // random processes drawn by IntScenario
+    static constexpr int FundProcesses = 11;  // random processes drawn by FundScenario
+    static constexpr int TotalProcesses = RateProcesses + FundProcesses;
+
+    static constexpr int BridgeLevelsFromSobol = 64;  // bridge points per process taken from the Sobol point
+    static constexpr int Dimensions = TotalProcesses * BridgeLevelsFromSobol;
+
+private:
+
+    uint32_t pointIndex = 0;
+    RandomStream stream = RandomStream::InterestRates;
+
+    Philox padding;  // pseudo-random normals for the bridge points beyond the Sobol dimensions
+
+    // Brownian bridge construction for paths of bridgeSteps months (unit time steps)
+    int bridgeSteps = 0;
+    std::vector<int> bridgeIndex, leftIndex, rightIndex;
+    std::vector<double> leftWeight, rightWeight, stdDev;
+
+    std::vector<double> z;     // normals in bridge order for one process
+    std::vector<double> path;  // Brownian path for one process
+
+    void setupBridge(int numSteps);
+
+    // Coordinate dim of Sobol point pointIndex, as a uniform in (0, 1)
+    double sobolUniform(int dim) const;
+
+public:
+
+    void Seed(int scenNumber, RandomStream stream);
+
+    // Fills out with standard normal shocks stored month by month, numProcesses per month
+    void FillNormals(std::span<double> out, int numProcesses);
+};
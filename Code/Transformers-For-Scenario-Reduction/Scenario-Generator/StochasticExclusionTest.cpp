@@ -1,6 +1,8 @@
 #include "StochasticExclusionTest.h"
 
 #include <cmath>
+#include <stdexcept>
+#include <string>
 
 
 bool isOdd(int aNumber)
@@ -169,3 +171,34 @@ double testShock(int scenarioNum, int durMonths, shockType whichShock)
 
     return result;
 }
+
+
+TestShockTable::TestShockTable(int numMonths) :
+    numMonths(numMonths)
+{
+    if (numMonths < 1)
+        throw std::invalid_argument("the stochastic exclusion test needs at least one month");
+
+    for (auto type : { LongIntShock, IntDiffShock, EquityShock })
+    {
+        actlib::table<double>& table = shocks[type - 1];
+
+        table = actlib::table<double>(X_Range{ .lo = 1, .hi = NumScenarios }, Y_Range{ .lo = 1, .hi = numMonths });
+
+        for (auto scenario = 1; scenario <= NumScenarios; scenario++)
+            for (auto month = 1; month <= numMonths; month++)
+                table(scenario, month) = testShock(scenario, month, type);
+    }
+}
+
+
+std::span<const double> TestShockTable::path(int scenarioNum, shockType whichShock) const
+{
+    if (scenarioNum < 1 || scenarioNum > NumScenarios)
+        throw std::out_of_range("there are " + std::to_string(NumScenarios) + " stochastic exclusion test scenarios, not scenario " + std::to_string(scenarioNum));
+
+    if (whichShock < LongIntShock || whichShock > EquityShock)
+        throw std::invalid_argument("unknown stochastic exclusion test shock type");
+
+    return shocks[whichShock - 1].col_span(scenarioNum);
+}
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <array>
+#include <span>
+
+#include "Table.h"
+
 enum shockType
 {
     // These values are used as arguments to the testShock() function
@@ -8,4 +13,40 @@ enum shockType
     EquityShock = 3,
 };
 
-double testShock(int scenarioNum, int durMonths, shockType whichShock);
\ No newline at end of file
+double testShock(int scenarioNum, int durMonths, shockType whichShock);
+
+
+/**
+ * The shocks of the 16 Stochastic Exclusion Test scenarios for every month of a projection.
+ *
+ * testShock() works each shock out from the scenario definitions, recursing into scenarios 1
+ * and 3 for scenarios 13 to 16.  The table is filled from testShock() once for the run, so the
+ * shocks are the same values, and the generators then read each scenario's shocks month by month
+ * from a contiguous path.  It is read-only once built and shared by every worker thread.
+ */
+
+class TestShockTable
+{
+public:
+
+    static constexpr int NumScenarios = 16;
+
+private:
+
+    int numMonths = 0;
+
+    // By shock type; column s holds the shocks of scenario s for months 1 to numMonths
+    std::array<actlib::table<double>, 3> shocks;
+
+public:
+
+    explicit TestShockTable(int numMonths);
+
+    int getNumMonths() const
+    {
+        return numMonths;
+    }
+
+    // testShock(scenarioNum, month, whichShock) for months 1 to getNumMonths(), at [month - 1]
+    std::span<const double> path(int scenarioNum, shockType whichShock) const;
+};
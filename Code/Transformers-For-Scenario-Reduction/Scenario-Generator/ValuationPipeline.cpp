@@ -0,0 +1,147 @@
+#include "ValuationPipeline.h"
+
+#include <map>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+
+
+ValuationPipeline::ValuationPipeline(const ValuationParams& params, const string& outputDir, int numScenarios, int numMonths, size_t queueCapacity) :
+    numMonths(numMonths),
+    valuedMonths(params.num_months),
+    valuation(params, outputDir, numScenarios),
+    queue(queueCapacity)
+{
+    if (params.num_months < 1 || params.num_months > numMonths)
+        throw std::invalid_argument("the valuation needs between 1 and " + std::to_string(numMonths) + " months of each scenario");
+
+    // As many buffers as one worker can have in flight: the one it fills, a full queue, and the one being valued
+    for (size_t i = 0; i < queueCapacity + 2; i++)
+        spareBuffers.emplace_back(FundScenario::NumOutputFunds * valuedMonths);
+}
+
+
+ValuationPipeline::~ValuationPipeline()
+{
+    if (valuationThread.joinable())
+    {
+        queue.close();
+        valuationThread.join();
+    }
+}
+
+
+void ValuationPipeline::start(int firstScenario)
+{
+    valuationThread = std::thread(&ValuationPipeline::run, this, firstScenario);
+}
+
+
+void ValuationPipeline::submit(int scenarioNumber, const FundScenario& fundScenario)
+{
+    if (fundScenario.getNumMonths() != numMonths)
+        throw std::invalid_argument("ValuationPipeline: scenario has the wrong number of months");
+
+    // The same total returns the scenario files hold, up to the months the GMIB program would read
+    Record record{ .scenarioNumber = scenarioNumber, .returns = takeBuffer() };
+
+    for (auto fund = 0; fund < FundScenario::NumOutputFunds; fund++)
+    {
+        std::span<const double> wealth = fundScenario.wealthFactors(fund);
+        double* out = record.returns.data() + fund * valuedMonths;
+
+        for (auto month = 1; month <= valuedMonths; month++)
+            out[month - 1] = wealth[month] / wealth[month - 1] - 1;
+    }
+
+    if (queue.push(std::move(record)))
+        return;
+
+    // The queue is only closed by finish() or the destructor; a failed valuation keeps draining it
+    throw std::logic_error("scenario " + std::to_string(scenarioNumber) + " was submitted after the valuation was finished");
+}
+
+
+std::vector<double> ValuationPipeline::takeBuffer()
+{
+    {
+        std::lock_guard lock(spareMutex);
+
+        if (!spareBuffers.empty())
+        {
+            std::vector<double> buffer = std::move(spareBuffers.back());
+            spareBuffers.pop_back();
+            return buffer;
+        }
+    }
+
+    // Only with several workers while the pipeline fills up; after that there are always as many buffers as scenarios in flight
+    return std::vector<double>(FundScenario::NumOutputFunds * valuedMonths);
+}
+
+
+void ValuationPipeline::recycle(std::vector<double>&& buffer)
+{
+    std::lock_guard lock(spareMutex);
+    spareBuffers.push_back(std::move(buffer));
+}
+
+
+void ValuationPipeline::finish()
+{
+    queue.close();
+
+    if (valuationThread.joinable())
+        valuationThread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+
+    valuation.finish();
+}
+
+
+void ValuationPipeline::run(int firstScenario)
+{
+    // Scenarios that arrived ahead of the next one due.  The map's nodes come from a pool on this
+    // thread, so a node freed by one scenario is reused by a later one.
+    std::pmr::unsynchronized_pool_resource nodePool;
+    std::pmr::map<int, Record> pending(&nodePool);
+    int nextScenario = firstScenario;
+
+    while (auto record = queue.pop())
+    {
+        pending.emplace(record->scenarioNumber, std::move(*record));
+
+        while (!pending.empty() && pending.begin()->first == nextScenario)
+        {
+            value(pending.begin()->second);
+            pending.erase(pending.begin());
+            nextScenario++;
+        }
+    }
+
+    // Only reached with gaps if a worker stopped early; value what is left rather than drop it
+    for (auto& [scenarioNumber, record] : pending)
+        value(record);
+}
+
+
+void ValuationPipeline::value(Record& record)
+{
+    // After a failure the rest of the queue is drained without valuing it, so the workers are not left blocked
+    if (!error)
+    {
+        try
+        {
+            scenario.assign(record.returns.data(), valuedMonths);
+            valuation.value_scenario(record.scenarioNumber, scenario);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+    }
+
+    recycle(std::move(record.returns));
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BoundedQueue.h"
+
+#include "FundScenario.h"
+#include "Valuation.h"
+
+using std::string;
+
+/**
+ * This class values the generated scenarios with the GMIB model as they are generated,
+ * without writing scenario files for the GMIB program to read back.
+ *
+ * The worker threads submit the monthly returns of each finished scenario through a bounded
+ * queue, which blocks them while the valuation thread is behind taking records off it.  The
+ * valuation thread values the scenarios in scenario order, because the PVs are written and the
+ * variance report is worked out in that order, and holds back scenarios that finish early.
+ *
+ * The held back scenarios are not bounded: while one scenario is slow, the other threads keep
+ * generating and their scenarios wait in memory, one return buffer each.  With the usual chunked
+ * schedule that is typically up to the number of threads times the chunk size.
+ *
+ * Once the pipeline is running, nothing is allocated per scenario beyond that: the return buffers
+ * go back to a spare list once valued, and the valuation thread refills one Scenario.  Enough
+ * buffers for one worker thread are made up front, so a one-thread run allocates none as it goes.
+ */
+
+class ValuationPipeline
+{
+    struct Record
+    {
+        int scenarioNumber;
+        std::vector<double> returns;  // valuedMonths returns of each output fund, one fund after another
+    };
+
+    int numMonths;      // months generated
+    int valuedMonths;   // months passed on to the valuation
+
+    PortfolioValuation valuation;
+
+    actlib::bounded_queue<Record> queue;
+    std::thread valuationThread;
+
+    std::exception_ptr error;  // the first failure on the valuation thread, rethrown by finish()
+
+    Scenario scenario;  // the scenario being valued, refilled from each record
+
+    std::mutex spareMutex;
+    std::vector<std::vector<double>> spareBuffers;  // return buffers already valued, for reuse by submit()
+
+    std::vector<double> takeBuffer();
+    void recycle(std::vector<double>&& buffer);
+
+    void run(int firstScenario);
+    void value(Record& record);
+
+public:
+
+    // Writes result.json to outputDir.  params.num_months is the number of months valued,
+    // which must not exceed the months generated.
+    ValuationPipeline(const ValuationParams& params, const string& outputDir, int numScenarios, int numMonths, size_t queueCapacity);
+    ~ValuationPipeline();
+
+    void start(int firstScenario);
+
+    // Called from the worker threads; blocks while the queue is full.  Throws if the pipeline was already finished.
+    void submit(int scenarioNumber, const FundScenario& fundScenario);
+
+    // Waits for every submitted scenario to be valued, then closes result.json and prints the variance report
+    void finish();
+};
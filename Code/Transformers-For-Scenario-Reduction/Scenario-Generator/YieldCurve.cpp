@@ -1,12 +1,12 @@
 #include "YieldCurve.h"
 
 #include <cmath>
+#include <stdexcept>
 
 YieldCurve::YieldCurve() :
     interpolatedRates(Range{ .lo = 1, .hi = 10 }),
     generatedRates(Range{ .lo = 1, .hi = 2 }),
-    spotRates(Range{ .lo = 1, .hi = 10 }),
-    maturities(Range{ .lo = 1, .hi = 10 })
+    spotRates(Range{ .lo = 1, .hi = 10 })
 {
 
 }
@@ -34,33 +34,7 @@ double YieldCurve::rateAtIndex(int index) const
 
 double YieldCurve::rateAtMaturity(double maturityYrs) const
 {
-    // Linearly interpolates a rate given a maturity in years, based on rates at index maturities
-    double rate;
-
-    if (maturityYrs < 0.25)
-        rate = interpolatedRates(1);
-    else if (maturityYrs < 0.5)
-        rate = rateAtIndex(1) + ((maturityYrs - 0.25) / 0.25) * (interpolatedRates(2) - interpolatedRates(1));
-    else if (maturityYrs < 1)
-        rate = rateAtIndex(2) + ((maturityYrs - 0.5) / 0.5) * (interpolatedRates(3) - interpolatedRates(2));
-    else if (maturityYrs < 2)
-        rate = rateAtIndex(3) + ((maturityYrs - 1) / 1) * (interpolatedRates(4) - interpolatedRates(3));
-    else if (maturityYrs < 3)
-        rate = rateAtIndex(4) + ((maturityYrs - 2) / 1) * (interpolatedRates(5) - interpolatedRates(4));
-    else if (maturityYrs < 5)
-        rate = rateAtIndex(5) + ((maturityYrs - 3) / 2) * (interpolatedRates(6) - interpolatedRates(5));
-    else if (maturityYrs < 7)
-        rate = rateAtIndex(6) + ((maturityYrs - 5) / 2) * (interpolatedRates(7) - interpolatedRates(6));
-    else if (maturityYrs < 10)
-        rate = rateAtIndex(7) + ((maturityYrs - 7) / 3) * (interpolatedRates(8) - interpolatedRates(7));
-    else if (maturityYrs < 20)
-        rate = rateAtIndex(8) + ((maturityYrs - 10) / 10) * (interpolatedRates(9) - interpolatedRates(8));
-    else if (maturityYrs < 30)
-        rate = rateAtIndex(9) + ((maturityYrs - 20) / 10) * (interpolatedRates(10) - interpolatedRates(9));
-    else
-        rate = interpolatedRates(10);
-
-    return rate;
+    return view().rateAtMaturity(maturityYrs);
 }
 
 
@@ -70,6 +44,12 @@ double YieldCurve::getLogVolatility() const
 }
 
 
+YieldCurveView YieldCurve::view() const
+{
+    return YieldCurveView(&interpolatedRates(1));
+}
+
+
 void YieldCurve::Initialize(double shortRate, double longRate, double logVol)
 {
     /***************************************** floor the generated rates at 0.0001 = 0.01% *****************/
@@ -78,43 +58,51 @@ void YieldCurve::Initialize(double shortRate, double longRate, double logVol)
     logVolatility = logVol;
     /***************************************** floor the generated rates at 0.0001 = 0.01% *****************/
 
-    maturities(1) = 0.25;
-    maturities(2) = 0.5;
-    maturities(3) = 1;
-    maturities(4) = 2;
-    maturities(5) = 3;
-    maturities(6) = 5;
-    maturities(7) = 7;
-    maturities(8) = 10;
-    maturities(9) = 20;
-    maturities(10) = 30;
-
-    interpolateNS();
+    if (histCurves)
+        interpolate(*histCurves);
+    else
+        interpolateNS();
 
     spotRatesAvailable = false;
 }
 
 
-void YieldCurve::interpolate(HistCurves& HistData)
+void YieldCurve::setInterpolation(CurveInterpolation method, const HistCurves* HistData)
+{
+    if (method == CurveInterpolation::HISTORICAL && !HistData)
+        throw std::invalid_argument("historical curve interpolation needs the historical curves");
+
+    histCurves = method == CurveInterpolation::HISTORICAL ? HistData : nullptr;
+}
+
+
+void YieldCurve::interpolate(const HistCurves& HistData)
 {
-    actlib::vector<double> histRates(Range({ .lo = 1, .hi = 10 }));
     long histCurveIndex;
     double shortRatio, longRatio;
 
-    histCurveIndex = HistData.BestFittingCurve(generatedRates(1), generatedRates(2), generatedRates(3), 2);
+    // Only the 1 and 20 year rates are generated, so the 7 year rate of the Nelson-Siegel curve
+    // through them stands in for the mid rate when choosing the historical curve.  It is worked out
+    // as interpolateNS() does, without the other nine rates.
+    const NelsonSiegelTerms& nst = nelsonSiegelTerms();
 
-    for (int i = histRates.lower_bound(); i <= histRates.upper_bound(); i++)
-        histRates(i) = HistData.histCurveRateByIndex(histCurveIndex, i);
+    double b1 = (generatedRates(1) - generatedRates(2)) / (nst.const1 - nst.const20);
+    double b0 = generatedRates(1) - (b1 * nst.const1);
+    double midRate = b0 + b1 * (1 - nst.decay[6]) / nst.kt[6];
 
+    histCurveIndex = HistData.BestFittingCurve(generatedRates(1), midRate, generatedRates(2), 2);
+
+    // Read straight from the historical table: this runs every month, so nothing is allocated here
+    auto histRates = [&](int i) { return HistData.histCurveRateByIndex(histCurveIndex, i); };
 
     shortRatio = generatedRates(1) / histRates(3);
-    longRatio = generatedRates(3) / histRates(9);
+    longRatio = generatedRates(2) / histRates(9);
 
     for (auto i = 1; i <= 3; i++)
         interpolatedRates(i) = histRates(i) * shortRatio;
 
     for (auto i = 4; i <= 8; i++)
-        interpolatedRates(i) = histRates(i) * (shortRatio + (longRatio - shortRatio) * (maturities(i) - maturities(3)) / 19);
+        interpolatedRates(i) = histRates(i) * (shortRatio + (longRatio - shortRatio) * (maturity(i) - maturity(3)) / 19);
 
     for (auto i = 9; i <= 10; i++)
         interpolatedRates(i) = histRates(i) * longRatio;
@@ -125,34 +113,50 @@ void YieldCurve::interpolate(HistCurves& HistData)
 }
 
 
-void YieldCurve::interpolateNS()
+const YieldCurve::NelsonSiegelTerms& YieldCurve::nelsonSiegelTerms()
 {
-    // Use Nelson-Siegel two point interpolation
+    static const NelsonSiegelTerms terms = []() {
+        NelsonSiegelTerms nst;
+
+        double k = 0.4;
+        nst.const1 = (1 - exp(-k * 1)) / (k * 1);
+        nst.const20 = (1 - exp(-k * 20)) / (k * 20);
+
+        for (auto i = 1; i <= 10; i++)
+        {
+            double t = maturity(i);
+            if (t == 0)
+                t = 0.25;
+
+            nst.decay[i - 1] = exp(-k * t);
+            nst.kt[i - 1] = k * t;
+        }
 
-    double t;
+        return nst;
+    }();
+
+    return terms;
+}
+
+
+void YieldCurve::interpolateNS()
+{
+    // Use Nelson-Siegel two point interpolation.  The exponentials depend only on the
+    // maturities, so they come from nelsonSiegelTerms() instead of being recomputed.
+    const NelsonSiegelTerms& nst = nelsonSiegelTerms();
 
     double r1 = generatedRates(1);
     double r20 = generatedRates(2);
 
-    double k = 0.4;
-    double const1 = (1 - exp(-k * 1)) / (k * 1);
-    double const20 = (1 - exp(-k * 20)) / (k * 20);
-
-    double b1 = (r1 - r20) / (const1 - const20);
-    double b0 = r1 - (b1 * const1);
+    double b1 = (r1 - r20) / (nst.const1 - nst.const20);
+    double b0 = r1 - (b1 * nst.const1);
 
     for (auto i = 1; i <= 10; i++)
-    {
-        t = maturities(i);
-        if (t == 0)
-            t = 0.25;
-
-        interpolatedRates(i) = b0 + b1 * (1 - exp(-k * t)) / (k * t);
-    }
+        interpolatedRates(i) = b0 + b1 * (1 - nst.decay[i - 1]) / nst.kt[i - 1];
 }
 
 
-void YieldCurve::perturb(actlib::vector<double> adj, double portion)
+void YieldCurve::perturb(const actlib::vector<double>& adj, double portion)
 {
     // The argument array must have 10 points.  It is used to adjust
     // each of the 10 points on the interpolated yield curve.
@@ -242,31 +246,36 @@ void YieldCurve::calcSpotRates()
 
 }
 
-string YieldCurve::serializeToJson() const
+YieldCurveView::MaturityPoint YieldCurveView::maturityPoint(double maturityYrs)
 {
-    string json;
+    // Linear interpolation between the index maturities either side, flat beyond the ends
+    if (maturityYrs < 0.25)
+        return { 1, 1, 0 };
+    if (maturityYrs >= 30)
+        return { 10, 10, 0 };
 
-    json += "{";
+    int upper = 2;
 
-    auto maturityToString = [&](int idx) -> string
-    {
-        string s;
-        s += "\"" + std::to_string(maturities(idx)) + "\"";
-        s += ":";
-        s += std::to_string(rateAtIndex(idx));
+    while (maturityYrs >= YieldCurve::maturity(upper))
+        upper++;
 
-        return s;
-    };
+    double lowerYrs = YieldCurve::maturity(upper - 1);
 
-    for (auto i = maturities.lower_bound(); i < maturities.upper_bound(); i++)
-    {
-        json += maturityToString(i);
-        json += ",";// ",\n";
-    }
+    return { upper - 1, upper, (maturityYrs - lowerYrs) / (YieldCurve::maturity(upper) - lowerYrs) };
+}
 
-    json += maturityToString(maturities.upper_bound());
+void YieldCurveView::serializeToJson(JsonBuffer& out) const
+{
+    out.put('{');
+
+    for (auto i = 1; i <= YieldCurve::NumMaturities; i++)
+    {
+        out.putKey(YieldCurve::maturity(i));
+        out.putNumber(rateAtIndex(i));
 
-    json += "}";
+        if (i != YieldCurve::NumMaturities)
+            out.put(',');
+    }
 
-    return json;
+    out.put('}');
 }
\ No newline at end of file
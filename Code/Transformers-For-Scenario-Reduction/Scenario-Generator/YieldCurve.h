@@ -5,9 +5,68 @@
 #include "Vector.h"
 
 #include "HistCurves.h"
+#include "JsonBuffer.h"
 
 using std::string;
 
+
+/**
+ * A read-only view of the ten interpolated rates of one yield curve.
+ * The rates are not owned by the view; they are usually one month's row
+ * of the rate matrix in an IntScenario, or the rates of a YieldCurve.
+ */
+
+class YieldCurveView
+{
+    const double* rates;  // rates at the 10 index maturities, shortest first
+
+public:
+
+    // Where a maturity falls on the curve: its rate is the rate at index lower plus weight times
+    // the step to the rate at index upper.  Fixed maturities work this out once.
+    struct MaturityPoint
+    {
+        int lower;
+        int upper;
+        double weight;
+    };
+
+    static MaturityPoint maturityPoint(double maturityYrs);
+
+    explicit YieldCurveView(const double* rates) :
+        rates(rates)
+    {
+
+    }
+
+    double rateAtIndex(int index) const
+    {
+        // Retrieves one of the 10 interpolated rates (index 1 to 10)
+        return rates[index - 1];
+    }
+
+    double rateAt(const MaturityPoint& point) const
+    {
+        return rateAtIndex(point.lower) + point.weight * (rateAtIndex(point.upper) - rateAtIndex(point.lower));
+    }
+
+    double rateAtMaturity(double maturityYrs) const
+    {
+        return rateAt(maturityPoint(maturityYrs));
+    }
+
+    void serializeToJson(JsonBuffer& out) const;
+};
+
+
+// How the 10-point curve is filled in from the generated short and long rates
+enum class CurveInterpolation
+{
+    NELSON_SIEGEL,  // two point Nelson-Siegel curve
+    HISTORICAL      // shape of the best fitting historical curve, scaled to the generated rates
+};
+
+
 class YieldCurve
 {
     actlib::vector<double> interpolatedRates;
@@ -17,12 +76,34 @@ class YieldCurve
     actlib::vector<double> spotRates;
     bool spotRatesAvailable;
 
-    actlib::vector<double> maturities;
+    const HistCurves* histCurves = nullptr;  // set for CurveInterpolation::HISTORICAL
 
-    void interpolate(HistCurves& HistData);
+    void interpolate(const HistCurves& HistData);
 
 public:
 
+    // 10 Yield Curve points (3m, 6m, 1, 2, 3, 5, 7, 10, 20, 30 yrs), shared by every curve
+    static constexpr int NumMaturities = 10;
+    static constexpr double Maturities[NumMaturities] = { 0.25, 0.5, 1, 2, 3, 5, 7, 10, 20, 30 };
+
+    static double maturity(int index)
+    {
+        return Maturities[index - 1];
+    }
+
+    // The parts of the Nelson-Siegel interpolation that depend only on the maturities.
+    // Rate i of the curve is b0 + b1 * (1 - decay[i]) / kt[i], with i counted from 0.
+    struct NelsonSiegelTerms
+    {
+        double const1;               // loading of the 1 year generated rate
+        double const20;              // loading of the 20 year generated rate
+        double decay[NumMaturities]; // exp(-k t)
+        double kt[NumMaturities];    // k t
+    };
+
+    // Computed once, with the same operations interpolateNS() used to repeat for every curve
+    static const NelsonSiegelTerms& nelsonSiegelTerms();
+
     YieldCurve();
 
     double generatedRate(int i) const;
@@ -31,12 +112,15 @@ public:
     double rateAtMaturity(double maturityYrs) const;
     double getLogVolatility() const;
 
+    YieldCurveView view() const;
+
+    // Initialize() interpolates with the Nelson-Siegel formula unless historical curves are given here.
+    // The curves must outlive this object.
+    void setInterpolation(CurveInterpolation method, const HistCurves* HistData);
+
     void Initialize(double shortRate, double longRate, double logVol);
 
     void interpolateNS();
-    void perturb(actlib::vector<double> adj, double portion);
+    void perturb(const actlib::vector<double>& adj, double portion);
     void calcSpotRates();
-
-    _NODISCARD string serializeToJson() const;
 };
-
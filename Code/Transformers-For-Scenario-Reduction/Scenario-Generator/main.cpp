@@ -1,4 +1,5 @@
 #include "ScenarioGenerator.h"
+#include "ParamFile.h"
 #include <fstream>
 #include <string>
 #include "argparse.hpp"
@@ -16,9 +17,23 @@ struct ScenarioGeneratorArgs : public argparse::Args
     string& param_file    = kwarg("param_file", "file with parameters for scenario generator");
     int& num_period       = kwarg("num_periods", "number of periods to generate");
     char& frequency       = kwarg("frequency", "the frequency to generate. 'a' for annual, 'q' for quarterly, 'm' for monthly", "m");
+    string& format        = kwarg("format", "output format. 'json' for one file per scenario, 'binary' for a single binary file").set_default("json");
+    string& rng           = kwarg("rng", "random number generator. 'mt' for the Mersenne Twister, 'philox' for the counter-based generator, 'sobol' for quasi-Monte Carlo").set_default("mt");
+    string& history_dir   = kwarg("history_dir", "directory holding the historical yield curves, one file per maturity (0.25.csv ... 30.csv)").set_default("C:\\Users\\scott\\source\\repos\\Scenario-Generator\\Historic-Curves\\");
+    string& history_file  = kwarg("history_file", "consolidated historical yield curve file (.csv, or .bin for binary); used instead of --history_dir").set_default("");
+    string& save_history  = kwarg("save_history", "write the historical yield curves to this consolidated file (.csv, or .bin for binary)").set_default("");
+    string& interpolation = kwarg("interpolation", "yield curve interpolation. 'ns' for Nelson-Siegel, 'historical' to scale the best fitting historical curve").set_default("ns");
+    bool& batch           = flag("batch", "generate several scenarios at once with vector instructions (Nelson-Siegel interpolation only)").set_default(false);
+    bool& antithetic      = flag("antithetic", "generate scenarios in mirrored pairs: each even scenario negates the random draws of the one before it").set_default(false);
+    bool& exclusion_test  = flag("exclusion_test", "generate the 16 deterministic scenarios of the stochastic exclusion test instead of stochastic ones").set_default(false);
+    bool& repair_correlations = flag("repair_correlations", "replace a fund correlation matrix that is not positive definite with the nearest one that is").set_default(false);
     bool& single_file     = flag("s,single_file", "a flag to write all output in a single file").set_default(false);
+    bool& unordered       = flag("unordered", "with --single_file, write scenarios as they finish instead of in scenario order").set_default(false);
+    string& value         = kwarg("value", "GMIB parameter file; value the scenarios as they are generated and write result.json instead of scenario files").set_default("");
+    bool& tee             = flag("tee", "with --value, also write the scenario files").set_default(false);
     int& num_scenarios    = kwarg("num_scenarios", "number of scenarios to generate");
     int& num_threads      = kwarg("threads,t", "number of threads").set_default(1);
+    int& chunk_size       = kwarg("chunk_size", "number of scenarios a thread claims at a time").set_default(8);
 };
 
 
@@ -31,128 +46,11 @@ int main(int argc, char** argv)
     ifstream param_file(args.param_file);
     json data = json::parse(param_file);
 
-    ScenarioGeneratorParams params;
-
-    params.correl12 = data["interest_rate_params"]["correl12"];
-    params.correl13 = data["interest_rate_params"]["correl13"];
-    params.correl23 = data["interest_rate_params"]["correl23"];
-
-    params.int_params.beta1  = data["interest_rate_params"]["beta1"];
-    params.int_params.beta2  = data["interest_rate_params"]["beta2"];
-    params.int_params.beta3  = data["interest_rate_params"]["beta3"];
-    
-    params.int_params.tau1   = data["interest_rate_params"]["tau1"];
-    params.int_params.tau2   = data["interest_rate_params"]["tau2"];
-    params.int_params.tau3   = data["interest_rate_params"]["tau3"];
-    
-    params.int_params.sigma2 = data["interest_rate_params"]["sigma2"];
-    params.int_params.sigma3 = data["interest_rate_params"]["sigma3"];
-    
-    params.int_params.psi    = data["interest_rate_params"]["psi"];
-    params.int_params.phi    = data["interest_rate_params"]["phi"];
-    params.int_params.theta  = data["interest_rate_params"]["theta"];
-    params.int_params.kappa  = data["interest_rate_params"]["kappa"];
-
-    params.int_params.initial_short_rate = data["interest_rate_params"]["init_rate_short"];
-    params.int_params.initial_long_rate  = data["interest_rate_params"]["init_rate_long"];
-    params.int_params.initial_volatility = data["interest_rate_params"]["init_vol"];
-
-    params.int_params.min_long_rate  = data["interest_rate_params"]["min_long_rate"];
-    params.int_params.max_long_rate  = data["interest_rate_params"]["max_long_rate"];
-    params.int_params.min_short_rate = data["interest_rate_params"]["min_short_rate"];
-
-    params.AggressiveVol    = data["equity_params"]["aggressive_vol"];
-    params.DiversifiedVol   = data["equity_params"]["diversified_vol"];
-    params.IntermediateVol  = data["equity_params"]["intermediate_vol"];
-    params.InternationalVol = data["equity_params"]["international_vol"];
-
-    params.update_consts();
-
-    actlib::table<double> correlationMatrix (11, 11);
-
-    vector<string> markets {"US_LogVol", "US_LogRet", "Intl_LogVol", "Intl_LogRet", "Small_LogVol", "Small_LogRet", "Aggr_LogVol", "Aggr_LogRet", "Money_Ret", "IT_Govt_Ret", "LTCorp_Ret"};
-
-    int j = 0;
-    for (auto i = 0; i < markets.size(); i++)
-    {
-        for (auto j = 0; j < markets.size(); j++)
-        {
-            correlationMatrix(i, j) = data["equity_correlations"][i][markets[i]][j][markets[j]];
-        }
-    }
+    ScenarioGeneratorParams params = readScenarioGeneratorParams(data);
+    actlib::table<double> correlationMatrix = readCorrelationMatrix(data);
 
     ScenarioGenerator scn_gen;
 
-    params.diversified_params.targetVol       = data["equity_params"]["diversified"]["target_vol"];
-    params.diversified_params.meanRevStrength = data["equity_params"]["diversified"]["mean_rev_strength"];
-    params.diversified_params.volStdDev       = data["equity_params"]["diversified"]["vol_std_dev"];
-    params.diversified_params.a               = data["equity_params"]["diversified"]["a"];
-    params.diversified_params.b               = data["equity_params"]["diversified"]["b"];
-    params.diversified_params.C               = data["equity_params"]["diversified"]["c"];
-    params.diversified_params.current_vol     = data["equity_params"]["diversified"]["current_vol"];
-    params.diversified_params.minVol          = data["equity_params"]["diversified"]["min_vol"];
-    params.diversified_params.maxVolBefore    = data["equity_params"]["diversified"]["max_vol_before"];
-    params.diversified_params.maxVolAfter     = data["equity_params"]["diversified"]["max_vol_after"];
-    params.diversified_params.SETmedianReturn = data["equity_params"]["diversified"]["SETmedianReturn"];
-    params.diversified_params.SETvolatility   = data["equity_params"]["diversified"]["SETvolatility"];
-
-    params.international_params.targetVol       = data["equity_params"]["international"]["target_vol"];
-    params.international_params.meanRevStrength = data["equity_params"]["international"]["mean_rev_strength"];
-    params.international_params.volStdDev       = data["equity_params"]["international"]["vol_std_dev"];
-    params.international_params.a               = data["equity_params"]["international"]["a"];
-    params.international_params.b               = data["equity_params"]["international"]["b"];
-    params.international_params.C               = data["equity_params"]["international"]["c"];
-    params.international_params.current_vol     = data["equity_params"]["international"]["current_vol"];
-    params.international_params.minVol          = data["equity_params"]["international"]["min_vol"];
-    params.international_params.maxVolBefore    = data["equity_params"]["international"]["max_vol_before"];
-    params.international_params.maxVolAfter     = data["equity_params"]["international"]["max_vol_after"];
-    params.international_params.SETmedianReturn = data["equity_params"]["international"]["SETmedianReturn"];
-    params.international_params.SETvolatility   = data["equity_params"]["international"]["SETvolatility"];
-
-    params.intermediate_params.targetVol       = data["equity_params"]["intermediate"]["target_vol"];
-    params.intermediate_params.meanRevStrength = data["equity_params"]["intermediate"]["mean_rev_strength"];
-    params.intermediate_params.volStdDev       = data["equity_params"]["intermediate"]["vol_std_dev"];
-    params.intermediate_params.a               = data["equity_params"]["intermediate"]["a"];
-    params.intermediate_params.b               = data["equity_params"]["intermediate"]["b"];
-    params.intermediate_params.C               = data["equity_params"]["intermediate"]["c"];
-    params.intermediate_params.current_vol     = data["equity_params"]["intermediate"]["current_vol"];
-    params.intermediate_params.minVol          = data["equity_params"]["intermediate"]["min_vol"];
-    params.intermediate_params.maxVolBefore    = data["equity_params"]["intermediate"]["max_vol_before"];
-    params.intermediate_params.maxVolAfter     = data["equity_params"]["intermediate"]["max_vol_after"];
-    params.intermediate_params.SETmedianReturn = data["equity_params"]["intermediate"]["SETmedianReturn"];
-    params.intermediate_params.SETvolatility   = data["equity_params"]["intermediate"]["SETvolatility"];
-
-    params.aggressive_params.targetVol       = data["equity_params"]["aggressive"]["target_vol"];
-    params.aggressive_params.meanRevStrength = data["equity_params"]["aggressive"]["mean_rev_strength"];
-    params.aggressive_params.volStdDev       = data["equity_params"]["aggressive"]["vol_std_dev"];
-    params.aggressive_params.a               = data["equity_params"]["aggressive"]["a"];
-    params.aggressive_params.b               = data["equity_params"]["aggressive"]["b"];
-    params.aggressive_params.C               = data["equity_params"]["aggressive"]["c"];
-    params.aggressive_params.current_vol     = data["equity_params"]["aggressive"]["current_vol"];
-    params.aggressive_params.minVol          = data["equity_params"]["aggressive"]["min_vol"];
-    params.aggressive_params.maxVolBefore    = data["equity_params"]["aggressive"]["max_vol_before"];
-    params.aggressive_params.maxVolAfter     = data["equity_params"]["aggressive"]["max_vol_after"];
-    params.aggressive_params.SETmedianReturn = data["equity_params"]["aggressive"]["SETmedianReturn"];
-    params.aggressive_params.SETvolatility   = data["equity_params"]["aggressive"]["SETvolatility"];
-
-    params.money_market.maturity = data["bond_index_params"]["money_market"]["maturity"];
-    params.money_market.monthlyFactor = data["bond_index_params"]["money_market"]["monthly_factor"];
-    params.money_market.monthlySpread = data["bond_index_params"]["money_market"]["monthly_spread"];
-    params.money_market.duration = data["bond_index_params"]["money_market"]["duration"];
-    params.money_market.volatility = data["bond_index_params"]["money_market"]["volatility"];
-
-    params.us_intermed_govt.maturity = data["bond_index_params"]["us_intermed_govt"]["maturity"];
-    params.us_intermed_govt.monthlyFactor = data["bond_index_params"]["us_intermed_govt"]["monthly_factor"];
-    params.us_intermed_govt.monthlySpread = data["bond_index_params"]["us_intermed_govt"]["monthly_spread"];
-    params.us_intermed_govt.duration = data["bond_index_params"]["us_intermed_govt"]["duration"];
-    params.us_intermed_govt.volatility = data["bond_index_params"]["us_intermed_govt"]["volatility"];
-
-    params.us_long_corporate.maturity = data["bond_index_params"]["us_long_corporate"]["maturity"];
-    params.us_long_corporate.monthlyFactor = data["bond_index_params"]["us_long_corporate"]["monthly_factor"];
-    params.us_long_corporate.monthlySpread = data["bond_index_params"]["us_long_corporate"]["monthly_spread"];
-    params.us_long_corporate.duration = data["bond_index_params"]["us_long_corporate"]["duration"];
-    params.us_long_corporate.volatility = data["bond_index_params"]["us_long_corporate"]["volatility"];
-
     double DiversifiedVol   = data["equity_params"]["diversified_vol"];
     double InternationalVol = data["equity_params"]["international_vol"];
     double IntermediateVol  = data["equity_params"]["intermediate_vol"];
@@ -160,7 +58,7 @@ int main(int argc, char** argv)
 
     Date start_date {.month = Month::JANUARY, .year = 2022};
 
-    bool generateForStochExclTest = false;
+    bool generateForStochExclTest = args.exclusion_test;
     bool useNaicMeanRevPoint      = false;
     bool writeRNG                 = true;
     bool writeMultFiles           = !args.single_file;
@@ -178,10 +76,81 @@ int main(int argc, char** argv)
             }
         }();
 
+    OutputFormat format = [&]() {
+            if (args.format == "json")   return OutputFormat::JSON;
+            if (args.format == "binary") return OutputFormat::BINARY;
+            throw std::invalid_argument("unknown output format " + args.format);
+        }();
+
+    RandomGenerator rng = [&]() {
+            if (args.rng == "mt")     return RandomGenerator::MERSENNE_TWISTER;
+            if (args.rng == "philox") return RandomGenerator::PHILOX;
+            if (args.rng == "sobol")  return RandomGenerator::SOBOL;
+            throw std::invalid_argument("unknown random number generator " + args.rng);
+        }();
+
+    CurveInterpolation interpolation = [&]() {
+            if (args.interpolation == "ns")         return CurveInterpolation::NELSON_SIEGEL;
+            if (args.interpolation == "historical") return CurveInterpolation::HISTORICAL;
+            throw std::invalid_argument("unknown interpolation method " + args.interpolation);
+        }();
+
+    if (args.antithetic && num_scenarios % 2 != 0)
+        throw std::invalid_argument("--antithetic needs an even number of scenarios");
+
+    if (args.antithetic && generateForStochExclTest)
+        throw std::invalid_argument("the stochastic exclusion test scenarios take no random draws, so --antithetic does not apply");
+
     int num_years = args.num_period / periods_per_year(freq);
 
     string outputFolderName (args.out_path);
 
-    scn_gen.generateAllScenarios(freq, num_years, num_scenarios, start_date, generateForStochExclTest, useNaicMeanRevPoint, params, correlationMatrix, args.num_threads, args.out_path);
+    scn_gen.loadHistoricalCurves(args.history_dir, args.history_file);
+
+    if (!args.save_history.empty())
+        scn_gen.saveHistoricalCurves(args.save_history);
+
+    if (!args.value.empty())
+    {
+        ifstream gmib_param_file(args.value);
+        json gmib_data = json::parse(gmib_param_file);
+
+        // The GMIB program's parameters and defaults; by default every generated month is valued
+        ValuationParams valuation_params {
+            .num_months    = gmib_data.value("num_periods", num_years * 12),
+            .maturity_age  = gmib_data.value("maturity_age", 10),
+            .growth_rate   = gmib_data.value("growth_rate", 0.0),
+            .dep_amount    = gmib_data.value("deposit", 100'000.0),
+            .antithetic    = args.antithetic,
+            .control_means = gmib_data.value("control_means", string()),
+            .levels        = parse_levels(gmib_data.value("levels", string("70,90,99"))),
+            .write_results = !gmib_data.value("no_result_json", false),
+            .pv_file       = gmib_data.value("pv_file", string())
+        };
+
+        scn_gen.valueScenarios(valuation_params, args.tee);
+    }
+
+    ScenarioRunOptions run_options {
+        .frequency                = freq,
+        .projectionYears          = num_years,
+        .numScenarios             = num_scenarios,
+        .startDate                = start_date,
+        .generateForStochExclTest = generateForStochExclTest,
+        .useNaicMeanRevPoint      = useNaicMeanRevPoint,
+        .numThreads               = args.num_threads,
+        .chunkSize                = args.chunk_size,
+        .format                   = format,
+        .rng                      = rng,
+        .antithetic               = args.antithetic,
+        .repairCorrelations       = args.repair_correlations,
+        .interpolation            = interpolation,
+        .batch                    = args.batch,
+        .singleFile               = writeSingleFile,
+        .orderedSingleFile        = !args.unordered,
+        .outputDir                = args.out_path
+    };
+
+    scn_gen.generateAllScenarios(run_options, params, correlationMatrix);
     return 0;
 }
\ No newline at end of file
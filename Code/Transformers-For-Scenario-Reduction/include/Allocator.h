@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+/**
+ * A standard allocator that aligns every block to a cache line.
+ *
+ * actlib::table and actlib::vector use it by default, so their data, and the scratch buffers the
+ * batch kernels stream through, start on a 64 byte boundary: vector loads stepping through a
+ * buffer from its start never straddle two cache lines, and AVX-512 loads can be aligned ones.
+ * Any other standard allocator, e.g. std::pmr::polymorphic_allocator over an arena, can be
+ * given instead.
+ */
+
+namespace actlib
+{
+
+inline constexpr std::size_t cache_line_size = 64;
+
+template <typename T, std::size_t Alignment = cache_line_size>
+class aligned_allocator
+{
+    static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0, "alignment must be a power of two no smaller than the type's");
+
+public:
+
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = aligned_allocator<U, Alignment>;
+    };
+
+    aligned_allocator() noexcept = default;
+
+    template <typename U>
+    aligned_allocator(const aligned_allocator<U, Alignment>&) noexcept
+    {
+
+    }
+
+    _NODISCARD T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, std::size_t) noexcept
+    {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    friend bool operator==(const aligned_allocator&, const aligned_allocator<U, Alignment>&) noexcept
+    {
+        return true;
+    }
+};
+
+
+// A std::vector whose data starts on a cache line, for scratch buffers read with vector loads
+template <typename T>
+using aligned_vector = std::vector<T, aligned_allocator<T>>;
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace actlib
+{
+
+/**
+ * A fixed-capacity, thread-safe FIFO queue for handing work from producer threads to a consumer.
+ *
+ * push() blocks while the queue is full, which keeps fast producers from running arbitrarily far
+ * ahead of a slow consumer.  pop() blocks while the queue is empty and returns an empty optional
+ * once close() has been called and everything already queued has been taken.
+ *
+ * The items are held in a ring of capacity slots allocated up front, so pushing and popping
+ * never allocates; a popped slot is left moved-from until it is reused.
+ */
+
+template <typename T>
+class bounded_queue
+{
+    std::vector<T> _slots;
+    size_t _head = 0;   // slot of the oldest item
+    size_t _count = 0;
+    bool _closed = false;
+
+    std::mutex _mutex;
+    std::condition_variable _not_full;
+    std::condition_variable _not_empty;
+
+public:
+
+    explicit bounded_queue(size_t capacity) :
+        _slots(capacity > 0 ? capacity : 1)
+    {
+
+    }
+
+    bounded_queue(const bounded_queue&) = delete;
+    bounded_queue& operator=(const bounded_queue&) = delete;
+
+    // Returns false if the queue was closed before the item could be added
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        _not_full.wait(lock, [&]() { return _closed || _count < _slots.size(); });
+
+        if (_closed)
+            return false;
+
+        _slots[(_head + _count) % _slots.size()] = std::move(item);
+        _count++;
+
+        lock.unlock();
+        _not_empty.notify_one();
+
+        return true;
+    }
+
+    std::optional<T> pop()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        _not_empty.wait(lock, [&]() { return _closed || _count > 0; });
+
+        if (_count == 0)
+            return std::nullopt;
+
+        T item = std::move(_slots[_head]);
+        _head = (_head + 1) % _slots.size();
+        _count--;
+
+        lock.unlock();
+        _not_full.notify_one();
+
+        return item;
+    }
+
+    // No more items will be pushed.  Consumers drain what is left and then see an empty optional.
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _closed = true;
+        }
+
+        _not_full.notify_all();
+        _not_empty.notify_all();
+    }
+};
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <type_traits>
+
+/**
+ * Index checking policies for actlib::table and actlib::vector.
+ *
+ * With checked_indexing an out-of-range index throws table_out_of_bounds or vector_out_of_bounds.
+ * With unchecked_indexing operator() is plain pointer arithmetic, and an out-of-range index is
+ * undefined behaviour, so the hot loops compile to the same code as on a raw array.
+ *
+ * The default follows the build: checked in debug builds, unchecked in release builds (NDEBUG).
+ * Define ACTLIB_CHECKED_INDEXING as 1 or 0 to choose for a whole build, e.g. checked in a
+ * release build used for testing.  A single container can also name its policy, e.g.
+ * actlib::table<double, actlib::checked_indexing>.  at() is always checked and unchecked() never is.
+ */
+
+#ifndef ACTLIB_CHECKED_INDEXING
+#ifdef NDEBUG
+#define ACTLIB_CHECKED_INDEXING 0
+#else
+#define ACTLIB_CHECKED_INDEXING 1
+#endif
+#endif
+
+namespace actlib
+{
+
+struct checked_indexing
+{
+    static constexpr bool checked = true;
+};
+
+struct unchecked_indexing
+{
+    static constexpr bool checked = false;
+};
+
+using default_indexing = std::conditional_t<ACTLIB_CHECKED_INDEXING != 0, checked_indexing, unchecked_indexing>;
+
+}
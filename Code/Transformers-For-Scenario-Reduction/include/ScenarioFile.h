@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Layout of the binary scenario file written by the Scenario-Generator and read by the GMIB model.
+ *
+ * The file starts with a ScenarioFileHeader, followed by numFunds fixed-width fund names.
+ * The returns start at dataOffset and are stored one scenario after another.  Each scenario
+ * is a block of numFunds x numMonths doubles in which the monthly returns of one fund are
+ * stored contiguously, in the same fund order as the names in the header.
+ *
+ * All values are written in the native byte order of the machine that generated the file.
+ */
+
+constexpr char     SCENARIO_FILE_MAGIC[4]      = { 'S', 'C', 'N', 'B' };
+constexpr uint32_t SCENARIO_FILE_VERSION       = 1;
+constexpr int      SCENARIO_FILE_FUND_NAME_LEN = 32;
+constexpr uint64_t SCENARIO_FILE_ALIGNMENT     = 64;   // dataOffset is a multiple of this so scenario blocks are cache-line aligned in a mapping
+
+constexpr const char* SCENARIO_FILE_NAME = "scenarios.bin";  // name of the file within the output directory
+
+
+struct ScenarioFileHeader
+{
+    char     magic[4];
+    uint32_t version;
+    uint32_t numFunds;
+    uint32_t numMonths;
+    uint32_t numScenarios;
+    uint32_t reserved;
+    uint64_t dataOffset;
+};
+
+
+inline ScenarioFileHeader make_scenario_file_header(uint32_t numFunds, uint32_t numMonths, uint32_t numScenarios)
+{
+    ScenarioFileHeader header {};
+
+    std::memcpy(header.magic, SCENARIO_FILE_MAGIC, sizeof(header.magic));
+    header.version      = SCENARIO_FILE_VERSION;
+    header.numFunds     = numFunds;
+    header.numMonths    = numMonths;
+    header.numScenarios = numScenarios;
+
+    uint64_t namesEnd = sizeof(ScenarioFileHeader) + uint64_t(numFunds) * SCENARIO_FILE_FUND_NAME_LEN;
+    header.dataOffset = (namesEnd + SCENARIO_FILE_ALIGNMENT - 1) / SCENARIO_FILE_ALIGNMENT * SCENARIO_FILE_ALIGNMENT;
+
+    return header;
+}
+
+
+inline uint64_t scenario_block_size(const ScenarioFileHeader& header)
+{
+    return uint64_t(header.numFunds) * header.numMonths * sizeof(double);
+}
+
+
+// Scenario numbers start at 1, matching the scenario_N.json files
+inline uint64_t scenario_block_offset(const ScenarioFileHeader& header, int scenarioNum)
+{
+    return header.dataOffset + uint64_t(scenarioNum - 1) * scenario_block_size(header);
+}
+
+
+inline uint64_t scenario_file_size(const ScenarioFileHeader& header)
+{
+    return header.dataOffset + uint64_t(header.numScenarios) * scenario_block_size(header);
+}
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cstddef>
+#include <span>
+#include <type_traits>
 #include <vector>
 
+#include "Allocator.h"
+#include "Indexing.h"
 #include "Range.h"
 
 struct table_out_of_bounds {};
@@ -15,9 +20,79 @@ constexpr y_axis_t y_axis{};
 namespace actlib
 {
 
-template<typename T = double>
+// Non-owning view of every stride-th element starting at data, e.g. one row of a table across its
+// columns.  Indexed from 0 and never bounds-checked.
+template<typename T>
+class strided_view
+{
+    T* _first = nullptr;
+    int _size = 0;
+    int _stride = 1;
+
+public:
+
+    strided_view() = default;
+
+    strided_view(T* first, int size, int stride) noexcept :
+        _first(first),
+        _size(size),
+        _stride(stride)
+    {
+
+    }
+
+    _NODISCARD T& operator[](int idx) const noexcept
+    {
+        return _first[idx * _stride];
+    }
+
+    _NODISCARD int size() const noexcept
+    {
+        return _size;
+    }
+
+    _NODISCARD int stride() const noexcept
+    {
+        return _stride;
+    }
+
+    class iterator
+    {
+        T* _ptr;
+        int _stride;
+
+    public:
+
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::remove_cv_t<T>;
+
+        iterator(T* ptr, int stride) noexcept : _ptr(ptr), _stride(stride) {}
+
+        T& operator*() const noexcept { return *_ptr; }
+        iterator& operator++() noexcept { _ptr += _stride; return *this; }
+        iterator operator++(int) noexcept { auto tmp = *this; _ptr += _stride; return tmp; }
+
+        friend bool operator==(const iterator& lhs, const iterator& rhs) noexcept { return lhs._ptr == rhs._ptr; }
+        friend bool operator!=(const iterator& lhs, const iterator& rhs) noexcept { return lhs._ptr != rhs._ptr; }
+    };
+
+    _NODISCARD iterator begin() const noexcept
+    {
+        return iterator(_first, _stride);
+    }
+
+    _NODISCARD iterator end() const noexcept
+    {
+        return iterator(_first + std::ptrdiff_t(_size) * _stride, _stride);
+    }
+};
+
+
+template<typename T = double, typename Indexing = default_indexing, typename Allocator = aligned_allocator<T>>
 class table
 {
+    static constexpr bool checked = Indexing::checked;
+
     int _low_bound_x = 0;
     int _high_bound_x = 0;
     int _low_bound_y = 0;
@@ -26,14 +101,14 @@ class table
     int _size_x = 0;
     int _size_y = 0;
 
-    std::vector<T> _data;
+    std::vector<T, Allocator> _data;
 
     _NODISCARD int get_total_size(X_Range x_range, Y_Range y_range) const
     {
         return range_size(x_range) * range_size(y_range);
     }
 
-    _NODISCARD int get_internal_idx(int idx, x_axis_t) const
+    _NODISCARD int checked_internal_idx(int idx, x_axis_t) const
     {
         if (idx < _low_bound_x || idx > _high_bound_x)
         {
@@ -43,7 +118,7 @@ class table
         return idx - _low_bound_x;
     }
 
-    _NODISCARD int get_internal_idx(int idx, y_axis_t) const
+    _NODISCARD int checked_internal_idx(int idx, y_axis_t) const
     {
         if (idx < _low_bound_y || idx > _high_bound_y)
         {
@@ -53,9 +128,38 @@ class table
         return idx - _low_bound_y;
     }
 
-    _NODISCARD int get_strided_idx(int x, int y) const
+    _NODISCARD int checked_strided_idx(int x, int y) const
     {
-        return get_internal_idx(y, y_axis) + get_internal_idx(x, x_axis) * _size_y;
+        return checked_internal_idx(y, y_axis) + checked_internal_idx(x, x_axis) * _size_y;
+    }
+
+    _NODISCARD int unchecked_strided_idx(int x, int y) const noexcept
+    {
+        return (y - _low_bound_y) + (x - _low_bound_x) * _size_y;
+    }
+
+    _NODISCARD int get_internal_idx(int idx, x_axis_t) const noexcept(!checked)
+    {
+        if constexpr (checked)
+            return checked_internal_idx(idx, x_axis);
+        else
+            return idx - _low_bound_x;
+    }
+
+    _NODISCARD int get_internal_idx(int idx, y_axis_t) const noexcept(!checked)
+    {
+        if constexpr (checked)
+            return checked_internal_idx(idx, y_axis);
+        else
+            return idx - _low_bound_y;
+    }
+
+    _NODISCARD int get_strided_idx(int x, int y) const noexcept(!checked)
+    {
+        if constexpr (checked)
+            return checked_strided_idx(x, y);
+        else
+            return unchecked_strided_idx(x, y);
     }
 
 public:
@@ -100,16 +204,72 @@ public:
 
     ~table() = default;
 
-    _NODISCARD T operator()(int col, int row) const
+    // Checked or not as the Indexing policy says
+    _NODISCARD T operator()(int col, int row) const noexcept(!checked)
     {
         return _data[get_strided_idx(col, row)];
     }
 
-    _NODISCARD T& operator()(int col, int row)
+    _NODISCARD T& operator()(int col, int row) noexcept(!checked)
     {
         return _data[get_strided_idx(col, row)];
     }
 
+    // Always checked
+    _NODISCARD T at(int col, int row) const
+    {
+        return _data[checked_strided_idx(col, row)];
+    }
+
+    _NODISCARD T& at(int col, int row)
+    {
+        return _data[checked_strided_idx(col, row)];
+    }
+
+    // Never checked
+    _NODISCARD const T& unchecked(int col, int row) const noexcept
+    {
+        return _data[unchecked_strided_idx(col, row)];
+    }
+
+    _NODISCARD T& unchecked(int col, int row) noexcept
+    {
+        return _data[unchecked_strided_idx(col, row)];
+    }
+
+    // The elements (col, lower_bound(2)) to (col, upper_bound(2)) are stored contiguously; this points at the first
+    _NODISCARD const T* col_data(int col) const noexcept(!checked)
+    {
+        return _data.data() + get_internal_idx(col, x_axis) * _size_y;
+    }
+
+    _NODISCARD T* col_data(int col) noexcept(!checked)
+    {
+        return _data.data() + get_internal_idx(col, x_axis) * _size_y;
+    }
+
+    // The same elements as a span, for loops the compiler can vectorize
+    _NODISCARD std::span<const T> col_span(int col) const noexcept(!checked)
+    {
+        return { col_data(col), size_t(_size_y) };
+    }
+
+    _NODISCARD std::span<T> col_span(int col) noexcept(!checked)
+    {
+        return { col_data(col), size_t(_size_y) };
+    }
+
+    // The elements (lower_bound(1), row) to (upper_bound(1), row), one column apart in memory
+    _NODISCARD strided_view<const T> row_view(int row) const noexcept(!checked)
+    {
+        return { _data.data() + get_internal_idx(row, y_axis), _size_x, _size_y };
+    }
+
+    _NODISCARD strided_view<T> row_view(int row) noexcept(!checked)
+    {
+        return { _data.data() + get_internal_idx(row, y_axis), _size_x, _size_y };
+    }
+
     int lower_bound(int whichDim) const
     {
         if (whichDim == 1)
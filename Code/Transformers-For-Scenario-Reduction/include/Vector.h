@@ -1,7 +1,10 @@
 #pragma once
 
+#include <span>
 #include <vector>
 
+#include "Allocator.h"
+#include "Indexing.h"
 #include "Range.h"
 
 struct vector_out_of_bounds {};
@@ -15,22 +18,22 @@ struct reverse_sentinel_t {};
 
 
 
-template <typename T>
+template <typename T, typename Indexing = default_indexing, typename Allocator = aligned_allocator<T>>
 class vector;
 
 
 
-template <typename T>
+template <typename T, typename Indexing = default_indexing, typename Allocator = aligned_allocator<T>>
 class const_iterator
 {
-    friend actlib::vector<T>;
+    friend actlib::vector<T, Indexing, Allocator>;
 
-    const actlib::vector<T>& _data;
+    const actlib::vector<T, Indexing, Allocator>& _data;
     int _idx = 0;
 
 protected:
 
-    const_iterator(const vector<T>& data, int idx) :
+    const_iterator(const vector<T, Indexing, Allocator>& data, int idx) :
         _data(data),
         _idx(idx)
     {
@@ -136,7 +139,7 @@ public:
 
     difference_type operator-(const const_iterator & subtrahend)
     {
-        return subtrahend._idx - this->_idx;
+        return this->_idx - subtrahend._idx;
     }
 
     reference operator*()
@@ -151,15 +154,15 @@ public:
 };
 
 
-template <typename T>
-class iterator : public const_iterator<T>
+template <typename T, typename Indexing = default_indexing, typename Allocator = aligned_allocator<T>>
+class iterator : public const_iterator<T, Indexing, Allocator>
 {
-    friend actlib::vector<T>;
+    friend actlib::vector<T, Indexing, Allocator>;
 
-    using _MyBase           = const_iterator<T>;
+    using _MyBase           = const_iterator<T, Indexing, Allocator>;
 
-    iterator(vector<T>& data, int idx) :
-        const_iterator<T>(data, idx)
+    iterator(vector<T, Indexing, Allocator>& data, int idx) :
+        const_iterator<T, Indexing, Allocator>(data, idx)
     {
 
     }
@@ -233,7 +236,7 @@ public:
 
     difference_type operator-(const iterator& subtrahend)
     {
-        return subtrahend._idx - this->_idx;
+        return this->_idx - subtrahend._idx;
     }
 
     reference operator*()
@@ -354,15 +357,17 @@ public:
 
 
 
-template <typename T>
+template <typename T, typename Indexing, typename Allocator>
 class vector
 {
-    std::vector<T> _data;
+    static constexpr bool checked = Indexing::checked;
+
+    std::vector<T, Allocator> _data;
 
     int _low_bound = 0;
     int _high_bound = 0;
 
-    _NODISCARD int get_internal_idx(int idx) const
+    _NODISCARD int checked_internal_idx(int idx) const
     {
         if (idx < _low_bound || idx > _high_bound)
             throw vector_out_of_bounds{};
@@ -370,14 +375,22 @@ class vector
         return idx - _low_bound;
     }
 
+    _NODISCARD int get_internal_idx(int idx) const noexcept(!checked)
+    {
+        if constexpr (checked)
+            return checked_internal_idx(idx);
+        else
+            return idx - _low_bound;
+    }
+
 public:
 
     using value_type      = T;
-    using pointer         = typename std::vector<T>::pointer;
-    using const_pointer   = typename std::vector<T>::const_pointer;
+    using pointer         = typename std::vector<T, Allocator>::pointer;
+    using const_pointer   = typename std::vector<T, Allocator>::const_pointer;
     using reference       = T&;
-    using size_type       = typename std::vector<T>::size_type;
-    using difference_type = typename std::vector<T>::difference_type;
+    using size_type       = typename std::vector<T, Allocator>::size_type;
+    using difference_type = typename std::vector<T, Allocator>::difference_type;
 
     vector() :
         _low_bound(0),
@@ -435,16 +448,60 @@ public:
         return _high_bound;
     }
 
-    T& operator()(int idx)
+    // Checked or not as the Indexing policy says
+    T& operator()(int idx) noexcept(!checked)
     {
         return _data[get_internal_idx(idx)];
     }
 
-    const T& operator()(int idx) const
+    const T& operator()(int idx) const noexcept(!checked)
     {
         return _data[get_internal_idx(idx)];
     }
 
+    // Always checked
+    T& at(int idx)
+    {
+        return _data[checked_internal_idx(idx)];
+    }
+
+    const T& at(int idx) const
+    {
+        return _data[checked_internal_idx(idx)];
+    }
+
+    // Never checked
+    T& unchecked(int idx) noexcept
+    {
+        return _data[idx - _low_bound];
+    }
+
+    const T& unchecked(int idx) const noexcept
+    {
+        return _data[idx - _low_bound];
+    }
+
+    // The elements lower_bound() to upper_bound(), contiguous
+    T* data() noexcept
+    {
+        return _data.data();
+    }
+
+    const T* data() const noexcept
+    {
+        return _data.data();
+    }
+
+    std::span<T> span() noexcept
+    {
+        return _data;
+    }
+
+    std::span<const T> span() const noexcept
+    {
+        return _data;
+    }
+
     void clear()
     {
         for (auto& i : _data)
@@ -468,24 +525,24 @@ public:
         return range_size(r);
     }   
 
-    iterator<value_type> begin()
+    iterator<value_type, Indexing, Allocator> begin()
     {
-        return iterator<value_type>(*this, _low_bound);
+        return iterator<value_type, Indexing, Allocator>(*this, _low_bound);
     }
 
-    const_iterator<value_type> cbegin() const
+    const_iterator<value_type, Indexing, Allocator> cbegin() const
     {
-        return const_iterator<value_type>(*this, _low_bound);
+        return const_iterator<value_type, Indexing, Allocator>(*this, _low_bound);
     }
 
-    reverse_iterator<iterator<value_type>> rbegin()
+    reverse_iterator<iterator<value_type, Indexing, Allocator>> rbegin()
     {
-        return reverse_iterator<iterator<value_type>>(iterator<value_type>(*this, _data.size() - 1));
+        return reverse_iterator<iterator<value_type, Indexing, Allocator>>(iterator<value_type, Indexing, Allocator>(*this, _data.size() - 1));
     }
 
-    reverse_iterator<const_iterator<value_type>> crbegin() const
+    reverse_iterator<const_iterator<value_type, Indexing, Allocator>> crbegin() const
     {
-        return reverse_iterator<const_iterator<value_type>>(const_iterator<value_type>(*this, _data.size() - 1));
+        return reverse_iterator<const_iterator<value_type, Indexing, Allocator>>(const_iterator<value_type, Indexing, Allocator>(*this, _data.size() - 1));
     }
 
     forward_sentinel_t end() const
@@ -0,0 +1,92 @@
+# Generates the same scenarios with and without --batch, checks that every number agrees to 1e-12, and times the two in binary format.
+# The batch kernels use their own exp, so the outputs are close rather than identical.  The files hold monthly returns, which can be
+# close to zero, so differences are taken relative to the larger of the return and 1 (the size of the gross return 1 + r).
+param(
+    [int]$NumScenarios = 64,
+    [int]$NumPeriods = 1200,
+    [double]$Tolerance = 1e-12,
+    [double]$TargetSpeedup = 3,
+    [string]$OutDir = "$env:TEMP\Scenario-Generator-batch\"
+)
+
+$scalarDir = Join-Path $OutDir "scalar\"
+$batchDir  = Join-Path $OutDir "batch\"
+
+New-Item -ItemType Directory -Force -Path $scalarDir, $batchDir | Out-Null
+
+./Scenario-Generator.exe --output_dir=$scalarDir --num_periods=$NumPeriods --frequency=m --num_scenarios=$NumScenarios --param_file=Scn-Gen-params.json -t=1 | Out-Null
+./Scenario-Generator.exe --output_dir=$batchDir --num_periods=$NumPeriods --frequency=m --num_scenarios=$NumScenarios --param_file=Scn-Gen-params.json -t=1 --batch | Out-Null
+
+# Every number in the scenario files, in file order
+function Get-Numbers($value)
+{
+    if ($value -is [System.Management.Automation.PSCustomObject])
+    {
+        foreach ($property in $value.PSObject.Properties) { Get-Numbers $property.Value }
+    }
+    elseif ($value -is [System.Array])
+    {
+        foreach ($item in $value) { Get-Numbers $item }
+    }
+    elseif ($value -is [ValueType])
+    {
+        [double]$value
+    }
+}
+
+$mismatches = 0
+$largest = 0.0
+
+foreach ($file in Get-ChildItem $scalarDir)
+{
+    $other = Join-Path $batchDir $file.Name
+
+    if (-not (Test-Path $other))
+    {
+        Write-Output "MISSING: $($file.Name)"
+        $mismatches++
+        continue
+    }
+
+    $expected = @(Get-Numbers (Get-Content $file.FullName -Raw | ConvertFrom-Json))
+    $actual   = @(Get-Numbers (Get-Content $other -Raw | ConvertFrom-Json))
+
+    if ($expected.Count -ne $actual.Count)
+    {
+        Write-Output "MISMATCH: $($file.Name) has $($expected.Count) numbers without --batch and $($actual.Count) with it"
+        $mismatches++
+        continue
+    }
+
+    $worst = 0.0
+
+    for ($i = 0; $i -lt $expected.Count; $i++)
+    {
+        $scale = [Math]::Max([Math]::Abs($expected[$i]), 1.0)
+        $worst = [Math]::Max($worst, [Math]::Abs($actual[$i] - $expected[$i]) / $scale)
+    }
+
+    $largest = [Math]::Max($largest, $worst)
+
+    if ($worst -gt $Tolerance)
+    {
+        Write-Output ("MISMATCH: {0} differs by {1:E2}" -f $file.Name, $worst)
+        $mismatches++
+    }
+}
+
+# Throughput, one thread and binary output so that the generation dominates
+$scalarSec = (Measure-Command { ./Scenario-Generator.exe --output_dir=$scalarDir --num_periods=$NumPeriods --frequency=m --num_scenarios=$NumScenarios --param_file=Scn-Gen-params.json -t=1 --format=binary | Out-Null }).TotalSeconds
+$batchSec  = (Measure-Command { ./Scenario-Generator.exe --output_dir=$batchDir --num_periods=$NumPeriods --frequency=m --num_scenarios=$NumScenarios --param_file=Scn-Gen-params.json -t=1 --format=binary --batch | Out-Null }).TotalSeconds
+$speedup   = $scalarSec / $batchSec
+
+Write-Output ("Without --batch {0:N2} s, with it {1:N2} s: speedup {2:N2}x (target {3:N1}x, {4})" -f $scalarSec, $batchSec, $speedup, $TargetSpeedup,
+    $(if ($speedup -ge $TargetSpeedup) { "met" } else { "not met" }))
+
+if ($mismatches -gt 0)
+{
+    Write-Output "$mismatches of $NumScenarios scenarios differ by more than $Tolerance with --batch"
+    exit 1
+}
+
+Write-Output ("All {0} scenarios agree with --batch; largest difference {1:E2}" -f $NumScenarios, $largest)
@@ -0,0 +1,36 @@
+# Generates the same scenarios with one thread and with several threads and checks that every output file matches byte for byte.
+param(
+    [int]$NumScenarios = 200,
+    [int]$NumPeriods = 1200,
+    [int]$Threads = 8,
+    [string]$OutDir = "$env:TEMP\Scenario-Generator-determinism\"
+)
+
+$singleDir = Join-Path $OutDir "t1\"
+$multiDir  = Join-Path $OutDir "t$Threads\"
+
+New-Item -ItemType Directory -Force -Path $singleDir, $multiDir | Out-Null
+
+./Scenario-Generator.exe --output_dir=$singleDir --num_periods=$NumPeriods --frequency=m --num_scenarios=$NumScenarios --param_file=Scn-Gen-params.json -t=1 | Out-Null
+./Scenario-Generator.exe --output_dir=$multiDir --num_periods=$NumPeriods --frequency=m --num_scenarios=$NumScenarios --param_file=Scn-Gen-params.json -t=$Threads | Out-Null
+
+$mismatches = 0
+
+foreach ($file in Get-ChildItem $singleDir)
+{
+    $other = Join-Path $multiDir $file.Name
+
+    if (-not (Test-Path $other) -or (Get-FileHash $file.FullName).Hash -ne (Get-FileHash $other).Hash)
+    {
+        Write-Output "MISMATCH: $($file.Name)"
+        $mismatches++
+    }
+}
+
+if ($mismatches -gt 0)
+{
+    Write-Output "$mismatches of $NumScenarios scenarios differ between 1 and $Threads threads"
+    exit 1
+}
+
+Write-Output "All $NumScenarios scenarios match between 1 and $Threads threads"
@@ -0,0 +1,41 @@
+# Compares how fast the GMIB present values settle down with Mersenne Twister and with Sobol scenarios.
+# For each scenario count it prints the mean PV and the CTE90 (mean of the worst 10%) next to a large Mersenne Twister run.
+param(
+    [int[]]$NumScenarios = @(128, 256, 512, 1024, 2048),
+    [int]$ReferenceScenarios = 8192,
+    [int]$NumPeriods = 1200,
+    [int]$Threads = 8,
+    [string]$OutDir = "$env:TEMP\Scenario-Generator-qmc\"
+)
+
+function Get-PvStats([string]$rng, [int]$count)
+{
+    $scnDir  = Join-Path $OutDir "$rng-$count\scenarios\"
+    $gmibDir = Join-Path $OutDir "$rng-$count\gmib\"
+
+    New-Item -ItemType Directory -Force -Path $scnDir, $gmibDir | Out-Null
+
+    ./Scenario-Generator.exe --output_dir=$scnDir --num_periods=$NumPeriods --frequency=m --num_scenarios=$count --param_file=Scn-Gen-params.json -t=$Threads --format=binary --rng=$rng | Out-Null
+    ./GMIB.exe --in=$scnDir --out=$gmibDir --num_periods=$NumPeriods --num_scenarios=$count --maturity_age=70 --growth_rate=0.05 --format=binary | Out-Null
+
+    $pvs = (Get-Content (Join-Path $gmibDir "result.json") | ConvertFrom-Json) | ForEach-Object { [double]$_.pv_cf } | Sort-Object -Descending
+    $tail = [Math]::Max(1, [int]($pvs.Count / 10))
+
+    [pscustomobject]@{
+        Mean  = ($pvs | Measure-Object -Average).Average
+        CTE90 = ($pvs[0..($tail - 1)] | Measure-Object -Average).Average
+    }
+}
+
+$reference = Get-PvStats "mt" $ReferenceScenarios
+Write-Output ("Reference (mt, {0} scenarios): mean {1:N0}  CTE90 {2:N0}" -f $ReferenceScenarios, $reference.Mean, $reference.CTE90)
+
+foreach ($count in $NumScenarios)
+{
+    $mt    = Get-PvStats "mt" $count
+    $sobol = Get-PvStats "sobol" $count
+
+    Write-Output ("{0,6}  mt: mean {1,12:N0} ({2,6:P2})  CTE90 {3,12:N0} ({4,6:P2})   sobol: mean {5,12:N0} ({6,6:P2})  CTE90 {7,12:N0} ({8,6:P2})" -f $count,
+        $mt.Mean, ($mt.Mean / $reference.Mean - 1), $mt.CTE90, ($mt.CTE90 / $reference.CTE90 - 1),
+        $sobol.Mean, ($sobol.Mean / $reference.Mean - 1), $sobol.CTE90, ($sobol.CTE90 / $reference.CTE90 - 1))
+}
@@ -0,0 +1,17 @@
+# Runs the benchmarks and checks of the Benchmarks project (build its Release configuration first).
+# Pass -Only with comma separated benchmark names to run some of them; the exit code is 1 if a check failed.
+param(
+    [string]$Only = "",
+    [string]$Benchmarks = ".\Transformers-For-Scenario-Reduction\x64\Release\Benchmarks.exe"
+)
+
+$arguments = @("--param_file=Scn-Gen-params.json")
+
+if ($Only -ne "")
+{
+    $arguments += "--only=$Only"
+}
+
+& $Benchmarks @arguments
+
+exit $LASTEXITCODE